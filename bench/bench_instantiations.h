@@ -0,0 +1,6 @@
+// Passed to the library as NGMIPS_BUS_INSTANTIATIONS when the bench is built,
+// so that the bench can compare the virtual bus with a devirtualized one
+#include "flat_bus.h"
+
+NGMIPS_INSTANTIATE(MipsTlbNormal, true, false, true, FlatBus)
+NGMIPS_INSTANTIATE(MipsTlbDummy, false, false, false, FlatBus)
@@ -0,0 +1,276 @@
+#include "bench_kernels.h"
+
+#include <cstring>
+
+namespace {
+
+const uint32_t kTlbVirtualAddress = 0x00400000;
+const uint32_t kTlbPhysicalAddress = 0x00200000;
+const int kCacheOpHitInvalidateI = 0x10;
+const int16_t kRspInputAddress = 0x000;
+const int16_t kRspOutputAddress = 0x800;
+const int16_t kRspVolumeAddress = 0xC00;
+
+uint32_t f32_bits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+void build_integer_loop(MipsAssembler& a, FlatBus& bus, const BenchLayout& layout) {
+  int start = a.NewLabel();
+  int loop = a.NewLabel();
+  a.Bind(start);
+  a.Addiu(kT0, kZero, 0);
+  a.Addiu(kT1, kZero, 1000);
+  a.Bind(loop);
+  a.Addiu(kT0, kT0, 1);
+  a.Xor(kT2, kT2, kT0);
+  a.Sll(kT3, kT0, 3);
+  a.Addu(kT4, kT4, kT3);
+  a.Slt(kT5, kT0, kT1);
+  a.Bne(kT5, kZero, loop);
+  a.Subu(kT6, kT4, kT2);
+  a.J(layout.code_address_);
+  a.Nop();
+}
+
+void build_memcpy(MipsAssembler& a, FlatBus& bus, const BenchLayout& layout) {
+  int loop = a.NewLabel();
+  a.Li(kA0, layout.data_address_);
+  a.Li(kA1, layout.data_address_ + 0x1000);
+  a.Addiu(kA2, kA0, 1024);
+  a.Bind(loop);
+  a.Lw(kT0, 0, kA0);
+  a.Lw(kT1, 4, kA0);
+  a.Addiu(kA0, kA0, 8);
+  a.Sw(kT0, 0, kA1);
+  a.Sw(kT1, 4, kA1);
+  a.Bne(kA0, kA2, loop);
+  a.Addiu(kA1, kA1, 8);
+  a.J(layout.code_address_);
+  a.Nop();
+
+  for (uint32_t i = 0; i < 256; i++) {
+    bus.Store32(layout.data_physical_ + i * 4, i * 0x01010101);
+  }
+}
+
+void build_load_store(MipsAssembler& a, FlatBus& bus, const BenchLayout& layout) {
+  // Nearly every instruction touches memory, so the translate-and-bus path
+  // dominates. On RSP/flat that path has no virtual calls left.
+  int loop = a.NewLabel();
+  a.Li(kA0, layout.data_address_);
+  a.Addiu(kA1, kA0, 512);
+  a.Bind(loop);
+  a.Lw(kT0, 0, kA0);
+  a.Lhu(kT1, 4, kA0);
+  a.Lb(kT2, 7, kA0);
+  a.Sw(kT1, 8, kA0);
+  a.Sh(kT0, 12, kA0);
+  a.Sb(kT2, 15, kA0);
+  a.Lh(kT3, 8, kA0);
+  a.Addiu(kA0, kA0, 16);
+  a.Bne(kA0, kA1, loop);
+  a.Sw(kT3, -4, kA0);
+  a.J(layout.code_address_);
+  a.Nop();
+
+  for (uint32_t i = 0; i < 128; i++) {
+    bus.Store32(layout.data_physical_ + i * 4, i * 0x01030507);
+  }
+}
+
+void build_unaligned_copy(MipsAssembler& a, FlatBus& bus, const BenchLayout& layout) {
+  // String-style copy between buffers with different misalignment
+  int loop = a.NewLabel();
+  a.Li(kA0, layout.data_address_ + 1);
+  a.Li(kA1, layout.data_address_ + 0x1003);
+  a.Addiu(kA2, kA0, 1024);
+  a.Bind(loop);
+  a.Lwl(kT0, 0, kA0);
+  a.Lwr(kT0, 3, kA0);
+  a.Addiu(kA0, kA0, 4);
+  a.Swl(kT0, 0, kA1);
+  a.Swr(kT0, 3, kA1);
+  a.Bne(kA0, kA2, loop);
+  a.Addiu(kA1, kA1, 4);
+  a.J(layout.code_address_);
+  a.Nop();
+
+  for (int i = 0; i < 1028; i++) {
+    bus.Store8(layout.data_physical_ + i, 'a' + i % 26);
+  }
+}
+
+void build_fpu_matrix(MipsAssembler& a, FlatBus& bus, const BenchLayout& layout) {
+  // out[4] = m[4][4] * v[4], single precision
+  int row = a.NewLabel();
+  a.Li(kA0, layout.data_address_);
+  a.Li(kA1, layout.data_address_ + 0x40);
+  a.Li(kA2, layout.data_address_ + 0x80);
+  a.Lwc1(4, 0, kA1);
+  a.Lwc1(5, 4, kA1);
+  a.Lwc1(6, 8, kA1);
+  a.Lwc1(7, 12, kA1);
+  a.Addiu(kT0, kZero, 4);
+  a.Bind(row);
+  a.Lwc1(0, 0, kA0);
+  a.Lwc1(1, 4, kA0);
+  a.Lwc1(2, 8, kA0);
+  a.Lwc1(3, 12, kA0);
+  a.MulS(8, 0, 4);
+  a.MulS(9, 1, 5);
+  a.MulS(10, 2, 6);
+  a.MulS(11, 3, 7);
+  a.AddS(8, 8, 9);
+  a.AddS(10, 10, 11);
+  a.AddS(8, 8, 10);
+  a.Swc1(8, 0, kA2);
+  a.Addiu(kA0, kA0, 16);
+  a.Addiu(kT0, kT0, -1);
+  a.Bne(kT0, kZero, row);
+  a.Addiu(kA2, kA2, 4);
+  a.J(layout.code_address_);
+  a.Nop();
+
+  for (int i = 0; i < 20; i++) {
+    bus.Store32(layout.data_physical_ + i * 4, f32_bits(0.25f * (i + 1)));
+  }
+}
+
+void build_tlb_mapped(MipsAssembler& a, FlatBus& bus, const BenchLayout& layout) {
+  // Loads and stores through a mapped even/odd 4 KB page pair
+  int loop = a.NewLabel();
+  a.Lui(kA0, kTlbVirtualAddress >> 16);
+  a.Addiu(kT0, kZero, 256);
+  a.Bind(loop);
+  a.Lw(kT1, 0, kA0);
+  a.Lw(kT2, 0x1000, kA0);
+  a.Addu(kT1, kT1, kT2);
+  a.Sw(kT1, 4, kA0);
+  a.Addiu(kT0, kT0, -1);
+  a.Bne(kT0, kZero, loop);
+  a.Addiu(kA0, kA0, 8);
+  a.J(layout.code_address_);
+  a.Nop();
+}
+
+void prepare_tlb_mapped(MipsInterface& cpu) {
+  uint64_t entry_hi = kTlbVirtualAddress;
+  uint64_t entry_lo0 = ((kTlbPhysicalAddress >> 12) << 6) | 0x7;  // D, V, G
+  uint64_t entry_lo1 = (((kTlbPhysicalAddress + 0x1000) >> 12) << 6) | 0x7;
+  cpu.GetTlb()->SetTlbEntry(0, MipsTlbEntry(entry_lo0, entry_lo1, entry_hi, 0));
+}
+
+void build_self_modifying(MipsAssembler& a, FlatBus& bus, const BenchLayout& layout) {
+  // Rewrites the immediate of an ADDIU every iteration and invalidates it
+  // with CACHE before jumping to it
+  uint32_t patch_address = layout.code_address_ + 0x100;
+  uint32_t patch_template = 0x25290000;  // addiu t1, t1, 0
+  a.Li(kS0, patch_template);
+  a.Li(kA0, patch_address);
+  uint32_t loop_address = a.Here();
+  a.Addiu(kT3, kT3, 1);
+  a.Andi(kT2, kT3, 0xFF);
+  a.Or(kT0, kS0, kT2);
+  a.Sw(kT0, 0, kA0);
+  a.Cache(kCacheOpHitInvalidateI, 0, kA0);
+  a.J(patch_address);
+  a.Nop();
+  while (a.Here() < patch_address) {
+    a.Nop();
+  }
+  a.Emit(patch_template);
+  a.J(loop_address);
+  a.Nop();
+}
+
+void build_cop0_random(MipsAssembler& a, FlatBus& bus, const BenchLayout& layout) {
+  // Folds the COP0 Random register into t1, which makes the result depend
+  // on the per-CPU generator state
+  int loop = a.NewLabel();
+  a.Bind(loop);
+  a.Mfc0(kT0, 1);
+  a.Xor(kT1, kT1, kT0);
+  a.Sll(kT2, kT1, 1);
+  a.Addu(kT1, kT1, kT2);
+  a.Beq(kZero, kZero, loop);
+  a.Nop();
+}
+
+void build_call_return(MipsAssembler& a, FlatBus& bus, const BenchLayout& layout) {
+  // Calls a leaf function with JAL and again through JALR. Both return with
+  // JR, so the return address goes through a GPR on every call.
+  uint32_t leaf_address = layout.code_address_ + 0x100;
+  int loop = a.NewLabel();
+  a.Li(kT9, leaf_address);
+  a.Bind(loop);
+  a.Jal(leaf_address);
+  a.Addiu(kA0, kA0, 1);
+  a.Addu(kT1, kT1, kV0);
+  a.Jalr(kRa, kT9);
+  a.Addiu(kA0, kA0, 3);
+  a.Beq(kZero, kZero, loop);
+  a.Xor(kT1, kT1, kV0);
+  while (a.Here() < leaf_address) {
+    a.Nop();
+  }
+  a.Sll(kV0, kA0, 2);
+  a.Jr(kRa);
+  a.Xor(kV0, kV0, kA0);
+}
+
+void build_vector_mix(MipsAssembler& a, FlatBus& bus, const BenchLayout& layout) {
+  // Mixes two 16-bit sample buffers with per-channel fractional volumes,
+  // eight samples per vector op, in the style of audio microcode. Vector
+  // accesses always address DMEM, so the buffers live there rather than at
+  // the layout's data address.
+  int loop = a.NewLabel();
+  a.Addiu(kA0, kZero, kRspInputAddress);
+  a.Addiu(kA1, kZero, kRspInputAddress + 0x400);
+  a.Addiu(kA2, kZero, kRspOutputAddress);
+  a.Addiu(kA3, kZero, kRspInputAddress + 0x400);
+  a.Addiu(kT0, kZero, kRspVolumeAddress);
+  a.Lqv(8, 0, kT0);
+  a.Bind(loop);
+  a.Lqv(1, 0, kA0);
+  a.Lqv(2, 0, kA1);
+  a.Lqv(3, 1, kA0);
+  a.Lqv(4, 1, kA1);
+  a.Vmulf(5, 1, 8, 8);
+  a.Vmacf(5, 2, 8, 9);
+  a.Vmulf(6, 3, 8, 8);
+  a.Vmacf(6, 4, 8, 9);
+  a.Sqv(5, 0, kA2);
+  a.Sqv(6, 1, kA2);
+  a.Addiu(kA0, kA0, 32);
+  a.Addiu(kA1, kA1, 32);
+  a.Bne(kA0, kA3, loop);
+  a.Addiu(kA2, kA2, 32);
+  a.J(layout.code_address_);
+  a.Nop();
+
+  for (uint32_t i = 0; i < 0x800; i += 2) {
+    bus.Store16(kRspInputAddress + i, i * 0x9E37);
+  }
+  bus.Store16(kRspVolumeAddress, 0x6000);
+  bus.Store16(kRspVolumeAddress + 2, 0x2000);
+}
+
+}  // namespace
+
+const BenchKernel kBenchKernels[] = {
+    {"integer-loop", false, false, build_integer_loop, nullptr},
+    {"memcpy", false, false, build_memcpy, nullptr},
+    {"load-store", false, false, build_load_store, nullptr},
+    {"lwl-lwr-copy", true, false, build_unaligned_copy, nullptr},
+    {"fpu-matrix", true, false, build_fpu_matrix, nullptr},
+    {"tlb-mapped", true, false, build_tlb_mapped, prepare_tlb_mapped},
+    {"self-modifying", true, false, build_self_modifying, nullptr},
+    {"cop0-random", true, false, build_cop0_random, nullptr},
+    {"call-return", false, false, build_call_return, nullptr},
+    {"rsp-vector-mix", false, true, build_vector_mix, nullptr},
+};
+
+const int kBenchKernelCount = sizeof(kBenchKernels) / sizeof(kBenchKernels[0]);
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+
+#include "flat_bus.h"
+#include "mips_asm.h"
+#include "mips_base.h"
+
+// Where a kernel lives. Virtual addresses are what the guest uses, physical
+// addresses are where the host places code and data in the FlatBus.
+struct BenchLayout {
+  uint32_t code_address_;
+  uint32_t code_physical_;
+  uint32_t data_address_;
+  uint32_t data_physical_;
+};
+
+// Every kernel loops forever so that it can be run for any cycle budget
+struct BenchKernel {
+  const char* name_;
+  bool n64_only_;
+  bool rsp_only_;
+  void (*build_)(MipsAssembler& a, FlatBus& bus, const BenchLayout& layout);
+  void (*prepare_)(MipsInterface& cpu);
+};
+
+extern const BenchKernel kBenchKernels[];
+extern const int kBenchKernelCount;
@@ -0,0 +1,348 @@
+#include <fmt/format.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "bench_kernels.h"
+#include "flat_bus.h"
+#include "mips_base.h"
+#include "mips_lockstep.h"
+#include "mips_skew_coordinator.h"
+
+#ifdef NGMIPS_BENCH_FLAT_BUS
+using N64FlatMips = MipsBase<MipsTlbNormal, true, false, true, FlatBus>;
+using RspFlatMips = MipsBase<MipsTlbDummy, false, false, false, FlatBus>;
+#endif
+
+// With final TLB and bus types every TranslateAddress and bus call on the
+// flat rows binds statically, so the RSP/flat memory path is free of
+// indirect calls
+static_assert(std::is_final_v<MipsTlbNormal> && std::is_final_v<MipsTlbDummy>);
+static_assert(std::is_final_v<FlatBus>);
+
+namespace {
+
+const int kDefaultCycleBudget = 20000000;
+const int kSliceCycles = 10000;
+const int kDefaultThreadCount = 8;
+const int kConcurrencyCheckCycles = 1000000;
+const uint64_t kLockstepSteps = 20000;
+// N64 and RSP slices for the skew coordinator row, a 3:2 clock ratio
+const int kSkewN64SliceCycles = 3000;
+const int kSkewRspSliceCycles = 2000;
+const int kSkewMaxSlices = 4;
+const int kMailboxPollInterval = 1000;
+
+// cpi_ = 0x100 makes one cycle equal to one retired instruction
+const uint16_t kBenchCpi = 0x100;
+
+const BenchLayout kN64Layout = {
+    .code_address_ = 0x80001000,
+    .code_physical_ = 0x00001000,
+    .data_address_ = 0x80100000,
+    .data_physical_ = 0x00100000,
+};
+
+const BenchLayout kRspLayout = {
+    .code_address_ = 0x00001000,
+    .code_physical_ = 0x00001000,
+    .data_address_ = 0x00100000,
+    .data_physical_ = 0x00100000,
+};
+
+MipsConfig get_n64_config(bool cached) {
+  MipsConfig config;
+  config.is_64bit_ = true;
+  config.use_big_endian_ = true;
+  config.has_exception_ = true;
+  config.has_cop0_ = true;
+  config.has_fpu_ = true;
+  config.use_cached_interpreter_ = cached;
+  config.cpi_ = kBenchCpi;
+  return config;
+}
+
+MipsConfig get_psx_config(bool cached) {
+  MipsConfig config;
+  config.use_big_endian_ = true;
+  config.has_load_delay_ = true;
+  config.has_exception_ = true;
+  config.has_cop0_ = true;
+  config.use_cached_interpreter_ = cached;
+  config.cpi_ = kBenchCpi;
+  return config;
+}
+
+MipsConfig get_rsp_config(bool cached) {
+  MipsConfig config;
+  config.use_big_endian_ = true;
+  config.has_rsp_vu_ = true;
+  config.use_cached_interpreter_ = cached;
+  config.cpi_ = kBenchCpi;
+  return config;
+}
+
+template <typename MipsT>
+std::unique_ptr<MipsT> create_cpu(const BenchKernel& kernel, const BenchLayout& layout, MipsConfig config) {
+  auto bus = std::make_shared<FlatBus>();
+  MipsAssembler a(layout.code_address_);
+  kernel.build_(a, *bus, layout);
+  bus->Write(layout.code_physical_, a.Finish());
+
+  auto cpu = std::make_unique<MipsT>(config);
+  cpu->ConnectBus(bus);
+  cpu->Reset();
+  if (kernel.prepare_ != nullptr) {
+    kernel.prepare_(*cpu);
+  }
+  cpu->SetPc(layout.code_address_);
+  return cpu;
+}
+
+// Returns millions of retired instructions per second
+template <typename MipsT>
+double measure(const BenchKernel& kernel, const BenchLayout& layout, MipsConfig config, int cycle_budget) {
+  std::unique_ptr<MipsT> cpu = create_cpu<MipsT>(kernel, layout, config);
+
+  // Warm up the block cache before timing
+  cpu->Run(cycle_budget / 10);
+
+  uint64_t start_timestamp = cpu->GetTimestamp();
+  auto start = std::chrono::steady_clock::now();
+  for (int spent = 0; spent < cycle_budget;) {
+    spent += cpu->Run(kSliceCycles);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  uint64_t inst_retired = cpu->GetTimestamp() - start_timestamp;
+  return inst_retired / seconds / 1e6;
+}
+
+template <typename MipsT>
+void run_kernel(const BenchKernel& kernel, const char* cpu_name, const BenchLayout& layout,
+                MipsConfig (*get_config)(bool), int cycle_budget) {
+  double interpreter = measure<MipsT>(kernel, layout, get_config(false), cycle_budget);
+  double cached = measure<MipsT>(kernel, layout, get_config(true), cycle_budget);
+  fmt::print("{:<16} {:<8} {:>12.2f} {:>12.2f} {:>8.2f}x\n", kernel.name_, cpu_name, interpreter, cached, cached / interpreter);
+}
+
+template <typename MipsT>
+std::vector<uint8_t> run_to_state(const BenchKernel& kernel, const BenchLayout& layout, MipsConfig config) {
+  std::unique_ptr<MipsT> cpu = create_cpu<MipsT>(kernel, layout, config);
+  for (int spent = 0; spent < kConcurrencyCheckCycles;) {
+    spent += cpu->Run(kSliceCycles);
+  }
+  std::vector<uint8_t> state;
+  cpu->SaveState(state);
+  return state;
+}
+
+// Same CPU choice as main(): RSP-only kernels need the vector unit
+std::vector<uint8_t> run_to_state(const BenchKernel& kernel) {
+  if (kernel.rsp_only_) {
+    return run_to_state<RspMips>(kernel, kRspLayout, get_rsp_config(true));
+  }
+  return run_to_state<N64Mips>(kernel, kN64Layout, get_n64_config(true));
+}
+
+// Instances share no mutable state, so each kernel must end in the same
+// state whether it runs alone or next to other instances on other threads
+bool check_concurrency(int thread_count) {
+  std::vector<std::vector<uint8_t>> expected;
+  for (int i = 0; i < kBenchKernelCount; i++) {
+    expected.push_back(run_to_state(kBenchKernels[i]));
+  }
+
+  std::atomic<int> mismatches = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_count; t++) {
+    threads.emplace_back([&, t]() {
+      for (int n = 0; n < kBenchKernelCount; n++) {
+        int i = (n + t) % kBenchKernelCount;
+        if (run_to_state(kBenchKernels[i]) != expected[i]) {
+          mismatches++;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  fmt::print("Concurrent instances ({} threads): {}\n", thread_count,
+             mismatches == 0 ? "deterministic" : fmt::format("{} mismatches", mismatches.load()));
+  return mismatches == 0;
+}
+
+// Runs the kernel on the plain and cached interpreters side by side, each
+// with its own copy of the memory
+template <typename MipsT>
+bool check_lockstep(const BenchKernel& kernel, const char* cpu_name, const BenchLayout& layout, MipsConfig config) {
+  std::shared_ptr<FlatBus> buses[2];
+  for (std::shared_ptr<FlatBus>& bus : buses) {
+    bus = std::make_shared<FlatBus>();
+    MipsAssembler a(layout.code_address_);
+    kernel.build_(a, *bus, layout);
+    bus->Write(layout.code_physical_, a.Finish());
+  }
+
+  MipsLockstep<MipsT> lockstep(config, buses[0], buses[1]);
+  lockstep.Reset();
+  if (kernel.prepare_ != nullptr) {
+    kernel.prepare_(lockstep.GetPlain());
+    kernel.prepare_(lockstep.GetCached());
+  }
+  lockstep.SetPc(layout.code_address_);
+  lockstep.Run(kLockstepSteps);
+  if (lockstep.HasDiverged()) {
+    fmt::print("Lockstep: {} on {}\n", kernel.name_, cpu_name);
+    lockstep.DumpDivergence();
+    return false;
+  }
+  return true;
+}
+
+// Same kernel and CPU pairs as the throughput table
+bool check_lockstep(const std::string& filter) {
+  int divergences = 0;
+  for (int i = 0; i < kBenchKernelCount; i++) {
+    const BenchKernel& kernel = kBenchKernels[i];
+    if (!filter.empty() && std::string(kernel.name_).find(filter) == std::string::npos) {
+      continue;
+    }
+    if (!kernel.rsp_only_ && !check_lockstep<N64Mips>(kernel, "N64", kN64Layout, get_n64_config(true))) {
+      divergences++;
+    }
+    if (!kernel.n64_only_ && !check_lockstep<RspMips>(kernel, "RSP", kRspLayout, get_rsp_config(true))) {
+      divergences++;
+    }
+    if (!kernel.n64_only_ && !kernel.rsp_only_ &&
+        !check_lockstep<PsxMips>(kernel, "PSX", kN64Layout, get_psx_config(true))) {
+      divergences++;
+    }
+  }
+
+  fmt::print("Plain vs cached lockstep ({} blocks per run): {}\n", kLockstepSteps,
+             divergences == 0 ? "no divergence" : fmt::format("{} divergences", divergences));
+  return divergences == 0;
+}
+
+// N64 and RSP on their own threads, talking through a mailbox register
+// every kMailboxPollInterval iterations: the N64 reads it, the RSP writes
+// its loop count to it
+void run_skew(int cycle_budget) {
+  auto bus = std::make_shared<MailboxBus>();
+
+  MipsAssembler n64(kN64Layout.code_address_);
+  n64.Lui(kA0, 0xA000 | (kMailboxAddress >> 16));
+  int n64_outer = n64.NewLabel();
+  int n64_inner = n64.NewLabel();
+  n64.Bind(n64_outer);
+  n64.Li(kT2, kMailboxPollInterval);
+  n64.Bind(n64_inner);
+  n64.Addiu(kT0, kT0, 1);
+  n64.Xor(kT1, kT1, kT0);
+  n64.Addiu(kT2, kT2, -1);
+  n64.Bne(kT2, kZero, n64_inner);
+  n64.Nop();
+  n64.Lw(kT3, 0, kA0);
+  n64.Addu(kT4, kT4, kT3);
+  n64.Beq(kZero, kZero, n64_outer);
+  n64.Nop();
+  bus->Write(kN64Layout.code_physical_, n64.Finish());
+
+  // Past the N64 code; the RSP sees physical addresses directly
+  const uint64_t rsp_code_address = 0x2000;
+  MipsAssembler rsp(rsp_code_address);
+  rsp.Lui(kA0, kMailboxAddress >> 16);
+  int rsp_outer = rsp.NewLabel();
+  int rsp_inner = rsp.NewLabel();
+  rsp.Bind(rsp_outer);
+  rsp.Li(kT2, kMailboxPollInterval);
+  rsp.Bind(rsp_inner);
+  rsp.Addiu(kT0, kT0, 1);
+  rsp.Addiu(kT2, kT2, -1);
+  rsp.Bne(kT2, kZero, rsp_inner);
+  rsp.Nop();
+  rsp.Sw(kT0, 0, kA0);
+  rsp.Beq(kZero, kZero, rsp_outer);
+  rsp.Nop();
+  bus->Write(rsp_code_address, rsp.Finish());
+
+  N64Mips n64_cpu(get_n64_config(true));
+  n64_cpu.ConnectBus(bus);
+  n64_cpu.Reset();
+  n64_cpu.SetPc(kN64Layout.code_address_);
+  RspMips rsp_cpu(get_rsp_config(true));
+  rsp_cpu.ConnectBus(bus);
+  rsp_cpu.Reset();
+  rsp_cpu.SetPc(rsp_code_address);
+
+  MipsSkewCoordinator coordinator(kSkewMaxSlices);
+  coordinator.AddProcessor(&n64_cpu, kSkewN64SliceCycles);
+  coordinator.AddProcessor(&rsp_cpu, kSkewRspSliceCycles);
+  coordinator.ConnectBus(bus.get());
+
+  auto start = std::chrono::steady_clock::now();
+  coordinator.Run(cycle_budget / kSkewN64SliceCycles);
+  auto end = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  uint64_t inst_retired = n64_cpu.GetInstRetired() + rsp_cpu.GetInstRetired();
+  fmt::print("Skew coordinator (N64+RSP threads): {:.2f} MIPS, {} mailbox syncs\n", inst_retired / seconds / 1e6,
+             bus->GetMailboxAccesses());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int cycle_budget = argc > 1 ? std::atoi(argv[1]) : kDefaultCycleBudget;
+  std::string filter = argc > 2 ? argv[2] : "";
+  int thread_count = argc > 3 ? std::atoi(argv[3]) : kDefaultThreadCount;
+
+  fmt::print("{:<16} {:<8} {:>12} {:>12} {:>9}\n", "kernel", "cpu", "Run MIPS", "Cached MIPS", "speedup");
+  for (int i = 0; i < kBenchKernelCount; i++) {
+    const BenchKernel& kernel = kBenchKernels[i];
+    if (!filter.empty() && std::string(kernel.name_).find(filter) == std::string::npos) {
+      continue;
+    }
+    if (!kernel.rsp_only_) {
+      run_kernel<N64Mips>(kernel, "N64", kN64Layout, get_n64_config, cycle_budget);
+    }
+    if (!kernel.n64_only_) {
+      run_kernel<RspMips>(kernel, "RSP", kRspLayout, get_rsp_config, cycle_budget);
+    }
+    // 32-bit kernels that are not RSP-specific also run on the R3000A
+    if (!kernel.n64_only_ && !kernel.rsp_only_) {
+      run_kernel<PsxMips>(kernel, "PSX", kN64Layout, get_psx_config, cycle_budget);
+    }
+#ifdef NGMIPS_BENCH_FLAT_BUS
+    if (!kernel.rsp_only_) {
+      run_kernel<N64FlatMips>(kernel, "N64/flat", kN64Layout, get_n64_config, cycle_budget);
+    }
+    if (!kernel.n64_only_) {
+      run_kernel<RspFlatMips>(kernel, "RSP/flat", kRspLayout, get_rsp_config, cycle_budget);
+    }
+#endif
+  }
+
+  if (filter.empty() || std::string("skew").find(filter) != std::string::npos) {
+    run_skew(cycle_budget);
+  }
+
+  if (!check_lockstep(filter)) {
+    return 1;
+  }
+
+  if (thread_count > 0 && !check_concurrency(thread_count)) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,210 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "bus_base.h"
+
+// Big-endian flat memory with no MMIO, mirrored every kFlatBusSize bytes
+const uint64_t kFlatBusSize = 8 * 1024 * 1024;
+
+class FlatBus final : public BusBase {
+ public:
+  FlatBus() : memory_(kFlatBusSize) {}
+
+  void Reset() override {}
+
+  LoadResult8 Load8(uint64_t address) override {
+    return LoadResult8{.has_value = true, .value = memory_[address & kMask]};
+  }
+
+  LoadResult16 Load16(uint64_t address) override {
+    uint16_t value;
+    memcpy(&value, &memory_[address & kMask & ~1ULL], sizeof(value));
+    return LoadResult16{.has_value = true, .value = __builtin_bswap16(value)};
+  }
+
+  LoadResult32 Load32(uint64_t address) override {
+    return LoadResult32{.has_value = true, .value = Read32(address)};
+  }
+
+  LoadResult64 Load64(uint64_t address) override {
+    uint64_t value = (static_cast<uint64_t>(Read32(address)) << 32) | Read32(address + 4);
+    return LoadResult64{.has_value = true, .value = value};
+  }
+
+  uint32_t Fetch(uint64_t address) override {
+    return Read32(address);
+  }
+
+  void Store8(uint64_t address, uint8_t value) override {
+    memory_[address & kMask] = value;
+  }
+
+  void Store16(uint64_t address, uint16_t value) override {
+    value = __builtin_bswap16(value);
+    memcpy(&memory_[address & kMask & ~1ULL], &value, sizeof(value));
+  }
+
+  void Store32(uint64_t address, uint32_t value) override {
+    value = __builtin_bswap32(value);
+    memcpy(&memory_[address & kMask & ~3ULL], &value, sizeof(value));
+  }
+
+  void Store64(uint64_t address, uint64_t value) override {
+    Store32(address, value >> 32);
+    Store32(address + 4, value);
+  }
+
+  bool GetInterrupt() override {
+    return false;
+  }
+
+  bool LoadBlock(uint64_t address, uint32_t* words, int count) override {
+    FetchBlock(address, words, count);
+    return true;
+  }
+
+  void StoreBlock(uint64_t address, const uint32_t* words, int count) override {
+    for (int i = 0; i < count; i++) {
+      Store32(address + i * 4, words[i]);
+    }
+  }
+
+  void FetchBlock(uint64_t address, uint32_t* words, int count) override {
+    for (int i = 0; i < count; i++) {
+      words[i] = Read32(address + i * 4);
+    }
+  }
+
+  bool HasFastFetchBlock() override {
+    return true;
+  }
+
+  // Words are laid out big-endian, so only big-endian CPUs can merge into
+  // them directly
+  void StoreMasked(uint64_t address, uint64_t value, uint64_t mask, int size, bool is_big_endian) override {
+    if (!is_big_endian) {
+      BusBase::StoreMasked(address, value, mask, size, is_big_endian);
+      return;
+    }
+    if (size == 4) {
+      uint32_t old_value = Read32(address);
+      Store32(address, (old_value & ~mask) | (value & mask));
+    } else {
+      uint64_t old_value = Load64(address).value;
+      Store64(address, (old_value & ~mask) | (value & mask));
+    }
+  }
+
+  // The first 4 KB double as RSP DMEM
+  uint8_t* GetDmemPointer() override {
+    return memory_.data();
+  }
+
+  uint32_t Read32(uint64_t address) {
+    uint32_t value;
+    memcpy(&value, &memory_[address & kMask & ~3ULL], sizeof(value));
+    return __builtin_bswap32(value);
+  }
+
+  void Write(uint64_t address, const std::vector<uint32_t>& words) {
+    for (uint32_t word : words) {
+      Store32(address, word);
+      address += 4;
+    }
+  }
+
+ private:
+  static constexpr uint64_t kMask = kFlatBusSize - 1;
+
+  std::vector<uint8_t> memory_;
+};
+
+// FlatBus plus one 32-bit mailbox register at kMailboxAddress that
+// processors on different threads use to talk to each other. Mailbox
+// accesses sync through SyncSharedAccess() first, so when run under
+// MipsSkewCoordinator each side sees the other at most one slice behind.
+const uint64_t kMailboxAddress = 0x04000000;
+
+class MailboxBus final : public BusBase {
+ public:
+  void Reset() override {}
+
+  LoadResult8 Load8(uint64_t address) override {
+    return memory_.Load8(address);
+  }
+
+  LoadResult16 Load16(uint64_t address) override {
+    return memory_.Load16(address);
+  }
+
+  LoadResult32 Load32(uint64_t address) override {
+    if ((address & ~3ULL) == kMailboxAddress) {
+      SyncSharedAccess();
+      mailbox_accesses_.fetch_add(1, std::memory_order_relaxed);
+      return LoadResult32{.has_value = true, .value = mailbox_.load(std::memory_order_acquire)};
+    }
+    return memory_.Load32(address);
+  }
+
+  LoadResult64 Load64(uint64_t address) override {
+    return memory_.Load64(address);
+  }
+
+  uint32_t Fetch(uint64_t address) override {
+    return memory_.Fetch(address);
+  }
+
+  void Store8(uint64_t address, uint8_t value) override {
+    memory_.Store8(address, value);
+  }
+
+  void Store16(uint64_t address, uint16_t value) override {
+    memory_.Store16(address, value);
+  }
+
+  void Store32(uint64_t address, uint32_t value) override {
+    if ((address & ~3ULL) == kMailboxAddress) {
+      SyncSharedAccess();
+      mailbox_accesses_.fetch_add(1, std::memory_order_relaxed);
+      mailbox_.store(value, std::memory_order_release);
+      return;
+    }
+    memory_.Store32(address, value);
+  }
+
+  void Store64(uint64_t address, uint64_t value) override {
+    memory_.Store64(address, value);
+  }
+
+  void StoreMasked(uint64_t address, uint64_t value, uint64_t mask, int size, bool is_big_endian) override {
+    memory_.StoreMasked(address, value, mask, size, is_big_endian);
+  }
+
+  bool GetInterrupt() override {
+    return false;
+  }
+
+  void FetchBlock(uint64_t address, uint32_t* words, int count) override {
+    memory_.FetchBlock(address, words, count);
+  }
+
+  bool HasFastFetchBlock() override {
+    return true;
+  }
+
+  void Write(uint64_t address, const std::vector<uint32_t>& words) {
+    memory_.Write(address, words);
+  }
+
+  uint64_t GetMailboxAccesses() const {
+    return mailbox_accesses_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  FlatBus memory_;
+  std::atomic<uint32_t> mailbox_ = 0;
+  std::atomic<uint64_t> mailbox_accesses_ = 0;
+};
@@ -0,0 +1,74 @@
+#include "mips_asm.h"
+
+#include "panic.h"
+
+namespace {
+
+const int kUnboundLabel = -1;
+
+}  // namespace
+
+MipsAssembler::MipsAssembler(uint32_t base) {
+  base_ = base;
+}
+
+int MipsAssembler::NewLabel() {
+  labels_.push_back(kUnboundLabel);
+  return labels_.size() - 1;
+}
+
+void MipsAssembler::Bind(int label) {
+  labels_[label] = code_.size();
+}
+
+void MipsAssembler::Align(int bytes) {
+  while (Here() % bytes != 0) {
+    Nop();
+  }
+}
+
+const std::vector<uint32_t>& MipsAssembler::Finish() {
+  for (const Fixup& fixup : fixups_) {
+    int target = labels_[fixup.label_];
+    if (target == kUnboundLabel) {
+      PANIC("Unbound label {}", fixup.label_);
+    }
+    int32_t offset = target - (fixup.index_ + 1);
+    code_[fixup.index_] |= static_cast<uint16_t>(offset);
+  }
+  fixups_.clear();
+  return code_;
+}
+
+void MipsAssembler::Li(int rt, uint32_t value) {
+  Lui(rt, value >> 16);
+  Ori(rt, rt, value & 0xFFFF);
+}
+
+void MipsAssembler::EmitR(int rs, int rt, int rd, int shamt, int funct) {
+  Emit((rs << 21) | (rt << 16) | (rd << 11) | (shamt << 6) | funct);
+}
+
+void MipsAssembler::EmitI(int op, int rs, int rt, uint16_t imm) {
+  Emit((op << 26) | (rs << 21) | (rt << 16) | imm);
+}
+
+void MipsAssembler::EmitFpu(int ft, int fs, int fd, int funct) {
+  // COP1, fmt = S
+  Emit((0x11 << 26) | (0x10 << 21) | (ft << 16) | (fs << 11) | (fd << 6) | funct);
+}
+
+void MipsAssembler::EmitVu(int vt, int vs, int vd, int e, int funct) {
+  // COP2 with the CO bit set
+  Emit((0x12 << 26) | (1 << 25) | ((e & 0xF) << 21) | (vt << 16) | (vs << 11) | (vd << 6) | funct);
+}
+
+void MipsAssembler::EmitVuMemory(int op, int kind, int vt, int offset, int base) {
+  // LWC2/SWC2 with element 0
+  Emit((op << 26) | (base << 21) | (vt << 16) | (kind << 11) | (offset & 0x7F));
+}
+
+void MipsAssembler::EmitBranch(int op, int rs, int rt, int label) {
+  fixups_.push_back(Fixup{.index_ = static_cast<int>(code_.size()), .label_ = label});
+  EmitI(op, rs, rt, 0);
+}
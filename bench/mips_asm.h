@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+enum MipsReg {
+  kZero = 0, kAt, kV0, kV1, kA0, kA1, kA2, kA3,
+  kT0, kT1, kT2, kT3, kT4, kT5, kT6, kT7,
+  kS0, kS1, kS2, kS3, kS4, kS5, kS6, kS7,
+  kT8, kT9, kK0, kK1, kGp, kSp, kFp, kRa
+};
+
+// Minimal assembler for hand-written benchmark kernels. Branch targets are
+// label ids which may be bound before or after the branch.
+class MipsAssembler {
+ public:
+  MipsAssembler(uint32_t base);
+
+  uint32_t Here() const { return base_ + code_.size() * 4; }
+  int NewLabel();
+  void Bind(int label);
+  void Align(int bytes);
+  const std::vector<uint32_t>& Finish();
+
+  void Addiu(int rt, int rs, int16_t imm) { EmitI(0x09, rs, rt, imm); }
+  void Andi(int rt, int rs, uint16_t imm) { EmitI(0x0C, rs, rt, imm); }
+  void Ori(int rt, int rs, uint16_t imm) { EmitI(0x0D, rs, rt, imm); }
+  void Lui(int rt, uint16_t imm) { EmitI(0x0F, 0, rt, imm); }
+  void Li(int rt, uint32_t value);
+
+  void Addu(int rd, int rs, int rt) { EmitR(rs, rt, rd, 0, 0x21); }
+  void Subu(int rd, int rs, int rt) { EmitR(rs, rt, rd, 0, 0x23); }
+  void And(int rd, int rs, int rt) { EmitR(rs, rt, rd, 0, 0x24); }
+  void Or(int rd, int rs, int rt) { EmitR(rs, rt, rd, 0, 0x25); }
+  void Xor(int rd, int rs, int rt) { EmitR(rs, rt, rd, 0, 0x26); }
+  void Slt(int rd, int rs, int rt) { EmitR(rs, rt, rd, 0, 0x2A); }
+  void Sll(int rd, int rt, int shamt) { EmitR(0, rt, rd, shamt, 0x00); }
+  void Srl(int rd, int rt, int shamt) { EmitR(0, rt, rd, shamt, 0x02); }
+  void Nop() { Emit(0); }
+
+  void Lb(int rt, int16_t offset, int base) { EmitI(0x20, base, rt, offset); }
+  void Lbu(int rt, int16_t offset, int base) { EmitI(0x24, base, rt, offset); }
+  void Lh(int rt, int16_t offset, int base) { EmitI(0x21, base, rt, offset); }
+  void Lhu(int rt, int16_t offset, int base) { EmitI(0x25, base, rt, offset); }
+  void Lw(int rt, int16_t offset, int base) { EmitI(0x23, base, rt, offset); }
+  void Lwl(int rt, int16_t offset, int base) { EmitI(0x22, base, rt, offset); }
+  void Lwr(int rt, int16_t offset, int base) { EmitI(0x26, base, rt, offset); }
+  void Sb(int rt, int16_t offset, int base) { EmitI(0x28, base, rt, offset); }
+  void Sh(int rt, int16_t offset, int base) { EmitI(0x29, base, rt, offset); }
+  void Sw(int rt, int16_t offset, int base) { EmitI(0x2B, base, rt, offset); }
+  void Swl(int rt, int16_t offset, int base) { EmitI(0x2A, base, rt, offset); }
+  void Swr(int rt, int16_t offset, int base) { EmitI(0x2E, base, rt, offset); }
+  void Cache(int op, int16_t offset, int base) { EmitI(0x2F, base, op, offset); }
+
+  void Mfc0(int rt, int rd) { Emit((0x10 << 26) | (rt << 16) | (rd << 11)); }
+
+  void Lwc1(int ft, int16_t offset, int base) { EmitI(0x31, base, ft, offset); }
+  void Swc1(int ft, int16_t offset, int base) { EmitI(0x39, base, ft, offset); }
+  void AddS(int fd, int fs, int ft) { EmitFpu(ft, fs, fd, 0x00); }
+  void MulS(int fd, int fs, int ft) { EmitFpu(ft, fs, fd, 0x02); }
+
+  // RSP vector unit. `e` is the element field, `offset` is in 16-byte units.
+  void Lqv(int vt, int offset, int base) { EmitVuMemory(0x32, 0x04, vt, offset, base); }
+  void Sqv(int vt, int offset, int base) { EmitVuMemory(0x3A, 0x04, vt, offset, base); }
+  void Vmulf(int vd, int vs, int vt, int e) { EmitVu(vt, vs, vd, e, 0x00); }
+  void Vmacf(int vd, int vs, int vt, int e) { EmitVu(vt, vs, vd, e, 0x08); }
+  void Vadd(int vd, int vs, int vt, int e) { EmitVu(vt, vs, vd, e, 0x10); }
+
+  void Beq(int rs, int rt, int label) { EmitBranch(0x04, rs, rt, label); }
+  void Bne(int rs, int rt, int label) { EmitBranch(0x05, rs, rt, label); }
+  void J(uint32_t target) { Emit((0x02 << 26) | ((target >> 2) & 0x3FFFFFF)); }
+  void Jal(uint32_t target) { Emit((0x03 << 26) | ((target >> 2) & 0x3FFFFFF)); }
+  void Jr(int rs) { EmitR(rs, 0, 0, 0, 0x08); }
+  void Jalr(int rd, int rs) { EmitR(rs, 0, rd, 0, 0x09); }
+
+  void Emit(uint32_t opcode) { code_.push_back(opcode); }
+
+ private:
+  struct Fixup {
+    int index_;
+    int label_;
+  };
+
+  void EmitR(int rs, int rt, int rd, int shamt, int funct);
+  void EmitI(int op, int rs, int rt, uint16_t imm);
+  void EmitFpu(int ft, int fs, int fd, int funct);
+  void EmitVu(int vt, int vs, int vd, int e, int funct);
+  void EmitVuMemory(int op, int kind, int vt, int offset, int base);
+  void EmitBranch(int op, int rs, int rt, int label);
+
+  uint32_t base_;
+  std::vector<uint32_t> code_;
+  std::vector<int> labels_;
+  std::vector<Fixup> fixups_;
+};
@@ -21,6 +21,15 @@ struct LoadResult64 {
   uint64_t value;
 };
 
+// Implemented by whatever runs the processors sharing a bus on separate
+// threads, e.g. MipsSkewCoordinator
+class BusSyncHandler {
+ public:
+  virtual ~BusSyncHandler() = default;
+  // Called from a processor thread before the bus touches shared state
+  virtual void SyncPoint() = 0;
+};
+
 class BusBase {
  public:
   virtual void Reset() = 0;
@@ -34,4 +43,80 @@ class BusBase {
   virtual void Store32(uint64_t address, uint32_t value) = 0;
   virtual void Store64(uint64_t address, uint64_t value) = 0;
   virtual bool GetInterrupt() = 0;
+
+  // Bulk transfers of consecutive 32-bit words, in the same form Load32 and
+  // Fetch return them. The defaults loop over the scalar calls; buses backed
+  // by plain memory should override them with a copy. LoadBlock returns
+  // false if any word was unmapped.
+  virtual bool LoadBlock(uint64_t address, uint32_t* words, int count) {
+    bool has_value = true;
+    for (int i = 0; i < count; i++) {
+      LoadResult32 result = Load32(address + i * 4);
+      words[i] = result.value;
+      has_value &= result.has_value;
+    }
+    return has_value;
+  }
+
+  virtual void StoreBlock(uint64_t address, const uint32_t* words, int count) {
+    for (int i = 0; i < count; i++) {
+      Store32(address + i * 4, words[i]);
+    }
+  }
+
+  virtual void FetchBlock(uint64_t address, uint32_t* words, int count) {
+    for (int i = 0; i < count; i++) {
+      words[i] = Fetch(address + i * 4);
+    }
+  }
+
+  // Stores the bytes selected by mask into the naturally aligned 4- or 8-byte
+  // word at address, as SWL/SWR and SDL/SDR do. value and mask hold the word
+  // the way the CPU sees it, and is_big_endian gives the byte order the CPU
+  // maps it to memory with. The default stores each selected byte with
+  // Store8, so MMIO only sees bytes the guest wrote; buses backed by plain
+  // memory should override it with one read-modify-write.
+  virtual void StoreMasked(uint64_t address, uint64_t value, uint64_t mask, int size, bool is_big_endian) {
+    for (int i = 0; i < size; i++) {
+      int shamt = (is_big_endian ? size - 1 - i : i) * 8;
+      if (((mask >> shamt) & 0xFF) != 0) {
+        Store8(address + i, value >> shamt);
+      }
+    }
+  }
+
+  // Whether FetchBlock is cheaper than one Fetch per word. Only then does the
+  // CPU fetch instructions ahead of the block it is building; otherwise it
+  // fetches them one at a time, so a bus without an override sees no extra
+  // calls. It is queried when the bus is connected.
+  virtual bool HasFastFetchBlock() {
+    return false;
+  }
+
+  // Host memory holding the RSP's 4 KB DMEM, byte n at offset n, or nullptr.
+  // The RSP vector unit then moves vectors to and from it directly instead
+  // of calling Load8/Store8. It is queried when the bus is connected and must
+  // stay valid while it is.
+  virtual uint8_t* GetDmemPointer() {
+    return nullptr;
+  }
+
+  // Set when the processors using this bus run on separate threads; nullptr
+  // (the default) when they share one
+  void SetSyncHandler(BusSyncHandler* handler) {
+    sync_handler_ = handler;
+  }
+
+ protected:
+  // Buses call this before touching state that processors on other threads
+  // also reach outside plain memory, such as shared MMIO registers. Plain
+  // RAM accesses do not need it.
+  void SyncSharedAccess() {
+    if (sync_handler_ != nullptr) {
+      sync_handler_->SyncPoint();
+    }
+  }
+
+ private:
+  BusSyncHandler* sync_handler_ = nullptr;
 };
\ No newline at end of file
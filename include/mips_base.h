@@ -1,16 +1,23 @@
 #pragma once
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "bus_base.h"
 #include "mips_cache.h"
 #include "mips_cop.h"
+#include "mips_decode.h"
+#include "mips_flat_cache.h"
 #include "mips_hook.h"
 #include "mips_tlb.h"
 #include "mips_tlb_dummy.h"
 #include "mips_tlb_normal.h"
 
+class MipsRspVu;
+
 typedef __int128_t int128_t;
 typedef __uint128_t uint128_t;
 
@@ -18,6 +25,12 @@ const bool kLazyInterruptPolling = false;
 const int kInterruptCheckInterval = 4;
 const int kMipsInstLogCount = 2048;
 
+#ifdef NGMIPS_INST_MIX
+const bool kEnableInstMix = true;
+#else
+const bool kEnableInstMix = false;
+#endif
+
 enum class ExceptionCause {
   kInt = 0,
   kTlbMod = 1,
@@ -42,6 +55,14 @@ struct MipsConfig {
   bool allow_misaligned_access_ = false;
   bool has_cop0_ = false;
   bool has_fpu_ = false;
+  // Built-in RSP vector unit as COP2. Its opcodes are resolved to direct
+  // handlers and bypass cop_decoding_override_; LWC2/SWC2 go straight to the
+  // bus, without TLB, hooks or watchpoints.
+  bool has_rsp_vu_ = false;
+  // Built-in PSX GTE as COP2, driven through the regular COP2 paths.
+  // use_fast_gte_ skips MAC overflow detection, leaving those FLAG bits clear.
+  bool has_psx_gte_ = false;
+  bool use_fast_gte_ = false;
   bool use_cached_interpreter_ = false;
   bool has_isolate_cache_bit_ = false;
   bool use_hook_ = false;
@@ -49,6 +70,57 @@ struct MipsConfig {
   uint16_t cpi_ = 0x180;
 };
 
+class MipsInterface;
+
+enum class MipsStopReason {
+  kPc,
+  kDeadline,
+  kPredicate,
+  kHalt,
+  kBreakpoint,
+  kWatchpoint,
+};
+
+enum class MipsDebugStopKind {
+  kNone,
+  kBreakpoint,
+  kWatchpoint,
+};
+
+// Why the last Run/RunUntil stopped early. Breakpoints stop before the
+// instruction executes; watchpoints let the access complete and stop at the
+// end of the block (after the instruction on the uncached path).
+struct MipsDebugStop {
+  MipsDebugStopKind kind_ = MipsDebugStopKind::kNone;
+  uint64_t pc_ = 0;       // Breakpoint PC or PC of the accessing instruction
+  uint64_t address_ = 0;  // Physical address of the watched access
+  uint64_t value_ = 0;
+  int size_ = 0;
+  bool is_store_ = false;
+};
+
+struct MipsWatchpoint {
+  uint64_t address_;  // Physical
+  uint32_t length_;
+  bool on_read_;
+  bool on_write_;
+};
+
+const int kWatchPageShift = 12;
+const int kWatchPageWords = (1ULL << (32 - kWatchPageShift)) / 64;
+
+// Stop conditions for RunUntil. Any combination may be set.
+struct MipsRunCondition {
+  // Stop before executing any of these PCs. The first instruction of a
+  // RunUntil call is never stopped on, so calling again resumes.
+  std::vector<uint64_t> stop_pcs_;
+  // Stop at the first instruction boundary where GetTimestamp() >= deadline_
+  uint64_t deadline_ = UINT64_MAX;
+  // Checked between blocks (after every taken or untaken branch delay slot
+  // on the uncached path)
+  std::function<bool(MipsInterface&)> predicate_;
+};
+
 class MipsLog {
  public:
   uint64_t pc_;
@@ -66,11 +138,22 @@ struct DelayedLoadOp {
 };
 
 // Non-templated abstract base — stable API for external code (buses, COPs, etc.)
+//
+// Threading: instances own all of their state, so independent CPUs (each with
+// its own bus and coprocessors) can run concurrently on different threads. A
+// single instance must only be driven from one thread at a time.
 class MipsInterface {
  public:
   virtual ~MipsInterface() = default;
   virtual void Reset() = 0;
   virtual int Run(int cycle) = 0;
+  virtual MipsStopReason RunUntil(const MipsRunCondition& condition) = 0;
+  virtual void AddBreakpoint(uint64_t pc) = 0;
+  virtual void RemoveBreakpoint(uint64_t pc) = 0;
+  virtual void ClearBreakpoints() = 0;
+  virtual void AddWatchpoint(uint64_t address, uint32_t length, bool on_read, bool on_write) = 0;
+  virtual void ClearWatchpoints() = 0;
+  virtual const MipsDebugStop& GetDebugStop() = 0;
   virtual void ConnectCop(std::shared_ptr<MipsCopBase> cop, int idx) = 0;
   virtual void ConnectBus(std::shared_ptr<BusBase> bus) = 0;
   virtual void ConnectHook(std::shared_ptr<MipsHookBase> hook, int idx) = 0;
@@ -79,10 +162,13 @@ class MipsInterface {
   virtual uint64_t GetPc() = 0;
   virtual uint64_t GetGpr(int idx) = 0;
   virtual void SetGpr(int idx, uint64_t value) = 0;
+  virtual uint64_t GetHi() = 0;
+  virtual uint64_t GetLo() = 0;
   virtual void SetLlbit(bool llbit) = 0;
   virtual bool GetHalt() = 0;
   virtual void SetHalt(bool halt) = 0;
   virtual uint64_t GetTimestamp() = 0;
+  virtual uint64_t GetInstRetired() = 0;
   virtual void CheckCompare() = 0;
   virtual void ClearCompareInterrupt() = 0;
   virtual void CheckInterrupt() = 0;
@@ -90,14 +176,38 @@ class MipsInterface {
   virtual MipsTlbBase* GetTlb() = 0;
   virtual void DumpProcessorLog() = 0;
   virtual void QueueCacheClear() = 0;
+  // Drops cached blocks overlapping [address, address + length) of physical
+  // memory. Buses call this when code memory is written (e.g. an IMEM DMA).
+  virtual void InvalidateCode(uint64_t address, uint32_t length) = 0;
+  virtual bool SaveBlockCache(const std::string& path) = 0;
+  virtual int LoadBlockCache(const std::string& path) = 0;
+  // Versioned, host-endian snapshot of CPU, COP and TLB state. Reusing the
+  // same buffer avoids reallocating on every save. LoadState returns false
+  // and changes nothing if the buffer is truncated, corrupt or was saved by
+  // a CPU with a different set of coprocessors.
+  virtual void SaveState(std::vector<uint8_t>& buffer) = 0;
+  virtual bool LoadState(const std::vector<uint8_t>& buffer) = 0;
+  virtual void DumpHotBlocks(int count) = 0;
+  virtual void ResetBlockProfile() = 0;
+  virtual MipsInstMix GetInstMix() = 0;
+  virtual void ResetInstMix() = 0;
+  virtual void DumpInstMix(int count) = 0;
 };
 
+// BusType defaults to the virtual BusBase. A build with a single concrete
+// bus can name it here instead; if the class is final, every memory access
+// in the instruction handlers becomes a direct, inlinable call. Concrete
+// types must still derive from BusBase and need an explicit instantiation,
+// see NGMIPS_BUS_INSTANTIATIONS in CMakeLists.txt.
 template <
     typename TlbType,
     bool kIs64Bit,
     bool kHasLoadDelay,
-    bool kHasCop0>
+    bool kHasCop0,
+    typename BusType = BusBase>
 class MipsBase : public MipsInterface {
+  static_assert(std::is_base_of_v<BusBase, BusType>, "BusType must derive from BusBase");
+
  public:
   MipsBase();
   MipsBase(MipsConfig config);
@@ -105,6 +215,16 @@ class MipsBase : public MipsInterface {
   void Reset() override;
   int Run(int cycle) override;
   int RunCached(int cycle);
+  // Runs exactly one cached block and returns the instructions it executed.
+  // Unlike RunCached, it polls neither interrupts nor compare.
+  int RunBlock();
+  MipsStopReason RunUntil(const MipsRunCondition& condition) override;
+  void AddBreakpoint(uint64_t pc) override;
+  void RemoveBreakpoint(uint64_t pc) override;
+  void ClearBreakpoints() override;
+  void AddWatchpoint(uint64_t address, uint32_t length, bool on_read, bool on_write) override;
+  void ClearWatchpoints() override;
+  const MipsDebugStop& GetDebugStop() override { return debug_stop_; }
   void RunInst();
   void ConnectCop(std::shared_ptr<MipsCopBase> cop, int idx) override;
   void ConnectBus(std::shared_ptr<BusBase> bus) override;
@@ -114,10 +234,13 @@ class MipsBase : public MipsInterface {
   uint64_t GetPc() override;
   uint64_t GetGpr(int idx) override;
   void SetGpr(int idx, uint64_t value) override;
+  uint64_t GetHi() override { return hi_; }
+  uint64_t GetLo() override { return lo_; }
   void SetLlbit(bool llbit) override;
   bool GetHalt() override;
   void SetHalt(bool halt) override;
   uint64_t GetTimestamp() override;
+  uint64_t GetInstRetired() override { return inst_retired_total_; }
   void CheckCompare() override;
   void ClearCompareInterrupt() override;
   void CheckInterrupt() override;
@@ -125,10 +248,24 @@ class MipsBase : public MipsInterface {
   MipsTlbBase* GetTlb() override { return &tlb_; }
   void DumpProcessorLog() override;
   void QueueCacheClear() override { cache_.QueueCacheClear(); }
+  void InvalidateCode(uint64_t address, uint32_t length) override;
+  bool SaveBlockCache(const std::string& path) override;
+  int LoadBlockCache(const std::string& path) override;
+  void SaveState(std::vector<uint8_t>& buffer) override;
+  bool LoadState(const std::vector<uint8_t>& buffer) override;
+  void DumpHotBlocks(int count) override;
+  void ResetBlockProfile() override;
+  MipsInstMix GetInstMix() override { return inst_mix_; }
+  void ResetInstMix() override { inst_mix_.fill(0); }
+  void DumpInstMix(int count) override;
 
  private:
   using inst_ptr_t = void (MipsBase::*)(uint32_t);
-  using Cache = MipsCache<MipsBase, TlbType>;
+  // The PSX's R3000A is the only core with a load delay. It also brings its
+  // own exception vectors and BIOS call hooks.
+  static constexpr bool kEnablePsxSpecific = kHasLoadDelay;
+  // Cores without COP0 (the RSP) run from a 4 KB code memory
+  using Cache = std::conditional_t<kHasCop0, MipsCache<MipsBase, TlbType>, MipsFlatCache<MipsBase, TlbType>>;
 
   auto GetInstFuncPtr(uint32_t opcode) -> inst_ptr_t;
   uint32_t ReadGpr32(int idx);
@@ -143,6 +280,12 @@ class MipsBase : public MipsInterface {
   void QueueDelayedLoad(int dst, uint64_t value);
   void QueueDelayedCopLoad(int cop_id, int dst, uint64_t value);
   void ExecuteDelayedLoad();
+  void CommitDelayedLoad();
+  // Where a load's value goes: delayed_load_op_, or straight to the register
+  template <bool kIsDelayed>
+  void CompleteLoad(int dst, uint64_t value);
+  template <bool kIsDelayed>
+  void CompleteCopLoad(int cop_id, int dst, uint64_t value);
   void TriggerException(ExceptionCause cause);
   void CheckHook();
   bool IsCopEnabled(int cop_id);
@@ -151,13 +294,39 @@ class MipsBase : public MipsInterface {
   LoadResult16 Load16(uint64_t address);
   LoadResult32 Load32(uint64_t address);
   LoadResult64 Load64(uint64_t address);
+  // Load the aligned word holding address, as LWL/LWR and LDL/LDR do.
+  // Exceptions report address itself in BadVAddr.
+  LoadResult32 LoadAligned32(uint64_t address);
+  LoadResult64 LoadAligned64(uint64_t address);
   void Store8(uint64_t address, uint8_t value);
   void Store16(uint64_t address, uint16_t value);
   void Store32(uint64_t address, uint32_t value);
   void Store64(uint64_t address, uint64_t value);
+  // Stores the bytes selected by mask into the aligned word holding address,
+  // as SWL/SWR do. The word is translated once and reaches the bus as one
+  // BusBase::StoreMasked call; hooks and watchpoints see each byte as its own
+  // 8-bit store. Exceptions report address itself in BadVAddr.
+  void StoreMasked32(uint64_t address, uint32_t value, uint32_t mask);
+  void StoreMasked64(uint64_t address, uint64_t value, uint64_t mask);
+  void StoreMaskedBytes(uint64_t address, uint64_t value, uint64_t mask, int size);
 
+  MipsCacheBlock<MipsBase>* GetOrCreateBlock();
+  int ExecuteBlock(MipsCacheBlock<MipsBase>* block, int limit);
+  template <bool kTracksLoadDelay>
+  int ExecuteEntries(const MipsCacheEntry<MipsBase>* entries, int limit);
+  MipsStopReason RunUntilCached(const MipsRunCondition& condition);
+  MipsStopReason RunUntilUncached(const MipsRunCondition& condition);
+  int GetInstCountUntil(uint64_t timestamp);
+  void RebuildBlocksAt(uint64_t pc);
+  void CheckWatchpoint(uint64_t address, int size, bool is_store, uint64_t value);
+  MipsStopReason GetDebugStopReason();
+  int FetchChunk(uint64_t address, uint32_t* opcodes);
   void OnNewBlock(uint64_t address);
+  void FuseUnalignedPairs(MipsCacheBlock<MipsBase>& block);
+  void ResolveLoadDelays(MipsCacheBlock<MipsBase>& block);
+  static inst_ptr_t GetDirectLoadFuncPtr(inst_ptr_t func);
   void InvalidateBlock(uint64_t address);
+  MipsCacheBlock<MipsBase>* RevalidateBlock(MipsCacheBlock<MipsBase>* block);
 
   void InstAdd(uint32_t opcode);
   void InstAddu(uint32_t opcode);
@@ -201,13 +370,21 @@ class MipsBase : public MipsInterface {
   void InstJalr(uint32_t opcode);
   void InstSyscall(uint32_t opcode);
   void InstBreak(uint32_t opcode);
+  // Loads that honor the load delay. Blocks use the kIsDelayed = false
+  // versions where the delay cannot be observed.
+  template <bool kIsDelayed>
   void InstLb(uint32_t opcode);
+  template <bool kIsDelayed>
   void InstLbu(uint32_t opcode);
+  template <bool kIsDelayed>
   void InstLh(uint32_t opcode);
+  template <bool kIsDelayed>
   void InstLhu(uint32_t opcode);
+  template <bool kIsDelayed>
   void InstLw(uint32_t opcode);
   void InstLwl(uint32_t opcode);
   void InstLwr(uint32_t opcode);
+  template <bool kIsDelayed>
   void InstLwc(uint32_t opcode);
   void InstSb(uint32_t opcode);
   void InstSh(uint32_t opcode);
@@ -269,9 +446,26 @@ class MipsBase : public MipsInterface {
   void InstSdc(uint32_t opcode);
   void InstSdl(uint32_t opcode);
   void InstSdr(uint32_t opcode);
+  // LWL/LWR-style load pairs fused by OnNewBlock, keyed on the pair's first
+  // opcode. The second entry of a pair runs InstFusedSecondHalf.
+  void InstFusedLw(uint32_t opcode);
+  void InstFusedLd(uint32_t opcode);
+  void InstFusedSecondHalf(uint32_t opcode);
   void InstSync(uint32_t opcode);
 
+  // COP2 handlers used when the built-in RSP vector unit is connected
+  auto GetVuFuncPtr(uint32_t opcode) -> inst_ptr_t;
+  template <void (MipsRspVu::*kOp)(uint32_t)>
+  void InstVuCompute(uint32_t opcode);
+  template <void (MipsRspVu::*kOp)(uint32_t, uint32_t)>
+  void InstVuMemory(uint32_t opcode);
+  void InstVuMfc(uint32_t opcode);
+  void InstVuCfc(uint32_t opcode);
+  void InstVuMtc(uint32_t opcode);
+  void InstVuCtc(uint32_t opcode);
+
   void InstUnknown(uint32_t opcode);
+  void InstBreakpoint(uint32_t opcode);
 
   uint64_t gpr_[32];
   uint64_t hi_;
@@ -284,6 +478,7 @@ class MipsBase : public MipsInterface {
   int cpi_counter_;
   int interrupt_poll_counter_;
   uint64_t cycle_spent_total_;
+  uint64_t inst_retired_total_;
   bool has_branch_delay_;
   uint64_t branch_delay_dst_;
   DelayedLoadOp delayed_load_op_;
@@ -296,19 +491,34 @@ class MipsBase : public MipsInterface {
   int mips_log_index_;
   MipsLog mips_log_[kMipsInstLogCount];
 
+  // Only updated when the library is built with NGMIPS_INST_MIX
+  MipsInstMix inst_mix_;
+
+  ankerl::unordered_dense::set<uint64_t> breakpoints_;
+  uint64_t breakpoint_resume_pc_;
+  std::vector<MipsWatchpoint> watchpoints_;
+  std::unique_ptr<uint64_t[]> watch_pages_;  // Allocated with the first watchpoint
+  MipsDebugStop debug_stop_;
+
   Cache cache_;
   bool halt_;
 
   MipsConfig config_;
 
  protected:
-  std::shared_ptr<BusBase> bus_;
+  std::shared_ptr<BusType> bus_;
+  bool has_fast_fetch_block_ = false;
+  // Bumped by LoadState; blocks built before it are rechecked before use
+  uint32_t state_epoch_ = 0;
   std::shared_ptr<MipsCopBase> cop_[4];
+  MipsRspVu* rsp_vu_ = nullptr;  // cop_[2] when it is the built-in vector unit
   TlbType tlb_;
 };
 
 using N64Mips = MipsBase<MipsTlbNormal, true, false, true>;
 using RspMips = MipsBase<MipsTlbDummy, false, false, false>;
+using PsxMips = MipsBase<MipsTlbDummy, false, true, true>;
 
 extern template class MipsBase<MipsTlbNormal, true, false, true>;
 extern template class MipsBase<MipsTlbDummy, false, false, false>;
+extern template class MipsBase<MipsTlbDummy, false, true, true>;
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "mips_base.h"
+
+// One unit of work for MipsBatchRunner, e.g. an N64Mips + RspMips pair with
+// their buses. RunSlice advances every processor of the job by about cycle.
+class MipsBatchJob {
+ public:
+  virtual ~MipsBatchJob() = default;
+  virtual void RunSlice(int cycle) = 0;
+  virtual uint64_t GetInstRetired() = 0;
+};
+
+// Runs a fixed list of processors back to back each slice. Anything else the
+// processors depend on (buses, COPs) must be kept alive by the factory, e.g.
+// through the shared_ptrs the processors hold.
+class MipsBatchCpuJob : public MipsBatchJob {
+ public:
+  MipsBatchCpuJob(std::vector<std::shared_ptr<MipsInterface>> cpus) : cpus_(std::move(cpus)) {}
+  void RunSlice(int cycle) override;
+  uint64_t GetInstRetired() override;
+
+ private:
+  std::vector<std::shared_ptr<MipsInterface>> cpus_;
+};
+
+using MipsBatchFactory = std::function<std::unique_ptr<MipsBatchJob>()>;
+
+struct MipsBatchStats {
+  uint64_t jobs_ = 0;
+  uint64_t inst_retired_ = 0;
+  uint64_t slices_ = 0;
+  uint64_t steals_ = 0;
+  double seconds_ = 0.0;
+
+  double GetMips() const { return seconds_ > 0.0 ? inst_retired_ / seconds_ / 1e6 : 0.0; }
+};
+
+// Drives many independent jobs over a work-stealing thread pool. Jobs are
+// dealt round-robin to the workers, and each worker starts its jobs in the
+// order they were added. A started job stays on its worker, slice after
+// slice, until its budget is spent, so that worker's caches stay warm. A
+// worker with an empty queue steals the job another worker would have
+// started last. Once there is nothing left to steal, no new work can appear,
+// so the worker exits instead of waiting. Jobs are created lazily by the
+// worker that first runs them.
+class MipsBatchRunner {
+ public:
+  MipsBatchRunner(int thread_count = 0);  // 0 = one per hardware thread
+  void AddJob(MipsBatchFactory factory, uint64_t cycle_budget);
+  MipsBatchStats Run(int slice_cycles);
+
+ private:
+  struct Job {
+    MipsBatchFactory factory_;
+    uint64_t cycle_budget_;
+  };
+
+  struct WorkerQueue {
+    std::mutex mutex_;
+    std::deque<Job*> jobs_;
+  };
+
+  void WorkerMain(int worker, int slice_cycles);
+  void RunJob(Job* job, int slice_cycles);
+  Job* PopLocal(int worker);
+  Job* Steal(int worker);
+
+  int thread_count_;
+  std::vector<std::unique_ptr<Job>> jobs_;
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::atomic<uint64_t> inst_retired_;
+  std::atomic<uint64_t> slices_;
+  std::atomic<uint64_t> steals_;
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bus_base.h"
+#include "mips_base.h"
+
+// Record/replay of the inputs a CPU sees through its bus. Loads from outside
+// the registered RAM ranges (MMIO, anything time dependent) and changes of the
+// interrupt line are logged with the CPU timestamp. Replaying the log against
+// the same program reproduces the run bit for bit.
+//
+// Log layout: MipsBusLogHeader, load stream, interrupt stream. Each stream is
+// a sequence of LEB128 varint records:
+//   load:      kind, timestamp delta, address, has_value, value
+//   interrupt: timestamp delta, GetInterrupt() call delta, level
+struct MipsBusLog {
+  std::vector<uint8_t> loads_;
+  std::vector<uint8_t> interrupts_;
+
+  bool Save(const std::string& path) const;
+  bool Load(const std::string& path);
+  void Clear();
+};
+
+class MipsBusRamRanges {
+ public:
+  void Add(uint64_t start, uint64_t end) { ranges_.emplace_back(start, end); }
+  bool Contains(uint64_t address) const {
+    for (const auto& [start, end] : ranges_) {
+      if (address >= start && address < end) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  std::vector<std::pair<uint64_t, uint64_t>> ranges_;
+};
+
+class MipsRecordingBus : public BusBase {
+ public:
+  MipsRecordingBus(std::shared_ptr<BusBase> bus);
+  // Source of the timestamps written to the log. Optional.
+  void ConnectCpu(MipsInterface* cpu) { cpu_ = cpu; }
+  // Memory whose contents only depend on the program (RAM, ROM). Loads from
+  // these ranges are not logged.
+  void AddRamRange(uint64_t start, uint64_t end) { ram_ranges_.Add(start, end); }
+  const MipsBusLog& GetLog() const { return log_; }
+  void ClearLog();
+
+  void Reset() override;
+  LoadResult8 Load8(uint64_t address) override;
+  LoadResult16 Load16(uint64_t address) override;
+  LoadResult32 Load32(uint64_t address) override;
+  LoadResult64 Load64(uint64_t address) override;
+  uint32_t Fetch(uint64_t address) override;
+  void Store8(uint64_t address, uint8_t value) override { bus_->Store8(address, value); }
+  void Store16(uint64_t address, uint16_t value) override { bus_->Store16(address, value); }
+  void Store32(uint64_t address, uint32_t value) override { bus_->Store32(address, value); }
+  void Store64(uint64_t address, uint64_t value) override { bus_->Store64(address, value); }
+  bool GetInterrupt() override;
+
+ private:
+  void RecordLoad(int kind, uint64_t address, bool has_value, uint64_t value);
+  uint64_t GetTimestamp() const { return cpu_ != nullptr ? cpu_->GetTimestamp() : 0; }
+
+  std::shared_ptr<BusBase> bus_;
+  MipsInterface* cpu_ = nullptr;
+  MipsBusRamRanges ram_ranges_;
+  MipsBusLog log_;
+  uint64_t last_load_timestamp_;
+  uint64_t last_interrupt_timestamp_;
+  uint64_t interrupt_calls_;
+  bool interrupt_level_;
+};
+
+// Forwards every access to the wrapped bus so devices still see the same
+// stores and reads, but answers non-RAM loads and GetInterrupt() from the
+// log. A load that does not match the next record is a desync and panics.
+class MipsReplayBus : public BusBase {
+ public:
+  MipsReplayBus(std::shared_ptr<BusBase> bus, MipsBusLog log);
+  // When connected, record timestamps are checked against the CPU as well
+  void ConnectCpu(MipsInterface* cpu) { cpu_ = cpu; }
+  // Must match the ranges used while recording
+  void AddRamRange(uint64_t start, uint64_t end) { ram_ranges_.Add(start, end); }
+  bool IsFinished() const;
+
+  void Reset() override;
+  LoadResult8 Load8(uint64_t address) override;
+  LoadResult16 Load16(uint64_t address) override;
+  LoadResult32 Load32(uint64_t address) override;
+  LoadResult64 Load64(uint64_t address) override;
+  uint32_t Fetch(uint64_t address) override;
+  void Store8(uint64_t address, uint8_t value) override { bus_->Store8(address, value); }
+  void Store16(uint64_t address, uint16_t value) override { bus_->Store16(address, value); }
+  void Store32(uint64_t address, uint32_t value) override { bus_->Store32(address, value); }
+  void Store64(uint64_t address, uint64_t value) override { bus_->Store64(address, value); }
+  bool GetInterrupt() override;
+
+ private:
+  LoadResult64 ReplayLoad(int kind, uint64_t address);
+  void ReadNextInterrupt();
+
+  std::shared_ptr<BusBase> bus_;
+  MipsInterface* cpu_ = nullptr;
+  MipsBusRamRanges ram_ranges_;
+  MipsBusLog log_;
+  size_t load_offset_;
+  size_t interrupt_offset_;
+  uint64_t last_load_timestamp_;
+  uint64_t last_interrupt_timestamp_;
+  uint64_t interrupt_calls_;
+  bool interrupt_level_;
+
+  bool has_next_interrupt_;
+  uint64_t next_interrupt_call_;
+  uint64_t next_interrupt_timestamp_;
+  bool next_interrupt_level_;
+};
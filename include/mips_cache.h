@@ -3,10 +3,19 @@
 
 #include <cstdint>
 #include <set>
+#include <vector>
+
+#include "mips_tlb.h"
 
 const int kCacheBlockMaxLength = 64;
 const int kLookupCacheSize = 64;
 
+#ifdef NGMIPS_BLOCK_PROFILER
+const bool kEnableBlockProfiler = true;
+#else
+const bool kEnableBlockProfiler = false;
+#endif
+
 template<typename MipsT>
 struct MipsCacheEntry {
   uint32_t address_;
@@ -14,6 +23,14 @@ struct MipsCacheEntry {
   void (MipsT::*func_)(uint32_t);
 };
 
+// Only updated when the library is built with NGMIPS_BLOCK_PROFILER
+struct MipsCacheBlockProfile {
+  uint64_t entries_ = 0;
+  uint64_t inst_retired_ = 0;
+  uint64_t early_exits_ = 0;  // Left before the last entry (exception, likely-branch nullification)
+  uint64_t cycles_ = 0;
+};
+
 template<typename MipsT>
 struct MipsCacheBlock {
   uint32_t start_;
@@ -21,8 +38,28 @@ struct MipsCacheBlock {
   MipsCacheEntry<MipsT> entries_[kCacheBlockMaxLength];
   int length_;
   int cycle_;
+  // Cores with a load delay: some load's target is read by the instruction
+  // right after it, so the block has to commit pending loads one
+  // instruction at a time
+  bool has_load_hazard_ = false;
+  // CPU's LoadState count when the code behind the block was last checked
+  uint32_t state_epoch_ = 0;
+  MipsCacheBlockProfile profile_;
 };
 
+// Serializable description of a discovered block. The code hash lets a later
+// session check that the bytes behind the block are still the same before
+// rebuilding it.
+struct MipsCacheBlockRecord {
+  uint32_t address_;  // Virtual address the block was entered from
+  uint32_t start_;    // Physical address of the first instruction
+  uint32_t length_;
+  uint32_t reserved_;
+  uint64_t hash_;
+};
+
+uint64_t HashBlockCode(const uint32_t* opcodes, int length);
+
 template<typename MipsT, typename TlbType>
 class MipsCache {
  public:
@@ -34,12 +71,26 @@ class MipsCache {
   void InsertBlock(const MipsCacheBlock<MipsT>& block);
   void InvalidateBlock(uint64_t address);
   void InvalidateBlockRange(uint64_t start, uint64_t end);
+  void InvalidatePhysicalBlock(uint64_t start);
+  void InvalidatePhysicalRange(uint64_t start, uint64_t end);
   size_t GetSize() { return cache_.size(); };
   void QueueCacheClear();
   void ExecuteCacheClear();
   bool HasPendingWork() const { return has_pending_work_; }
+  std::vector<MipsCacheBlockRecord> ExportBlocks();
+
+  template <typename Func>
+  void ForEachBlock(Func func) {
+    for (auto& [start, block] : cache_) {
+      func(block);
+    }
+  }
 
  private:
+  // Blocks are keyed by physical address. kseg0/kseg1 are unmapped, so they
+  // skip the TLB; this also keeps them working with MipsTlbDummy.
+  MipsTlbTranslationResult Translate(uint64_t address);
+
   ankerl::unordered_dense::map<uint64_t, MipsCacheBlock<MipsT>> cache_;
   std::set<uint64_t> pending_invalidations_;
   bool full_clear_queued_ = false;
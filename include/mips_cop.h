@@ -2,6 +2,8 @@
 #include <cstdint>
 
 class MipsInterface;  // forward declaration
+class MipsStateWriter;
+class MipsStateReader;
 
 class MipsCopBase {
 public:
@@ -17,4 +19,10 @@ public:
     virtual uint64_t Read64Internal(int idx) = 0;
     virtual void Write64Internal(int idx, uint64_t value) = 0;
     virtual bool GetFlag() = 0;
+    // Coprocessors without state to preserve can keep the empty defaults.
+    // LoadState decodes into temporaries and returns false if the section is
+    // short; registers are only written when commit is set, so the CPU can
+    // check every section before it changes any of them.
+    virtual void SaveState(MipsStateWriter& writer) {}
+    virtual bool LoadState(MipsStateReader& reader, bool commit) { return true; }
 };
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <cstdint>
 #include <string>
 
@@ -122,6 +123,11 @@ enum class MipsInstId {
   kUnknown
 };
 
+const int kMipsInstIdCount = static_cast<int>(MipsInstId::kUnknown) + 1;
+
+// Executed instruction counts indexed by MipsInstId
+using MipsInstMix = std::array<uint64_t, kMipsInstIdCount>;
+
 class RTypeInst {
  private:
   uint32_t raw_;
@@ -200,6 +206,7 @@ class MipsInst {
 };
 
 std::string GetInstName(uint32_t opcode);
+const char* GetInstIdName(MipsInstId id);
 MipsInstId Decode(uint32_t opcode);
 bool IsInstBranch(uint32_t opcode);
 bool DoesInstHaveDelaySlot(uint32_t opcode);
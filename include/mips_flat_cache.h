@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "mips_cache.h"
+
+// Code memories of this many words get one slot per word
+const int kFlatCacheSlotCount = 1024;
+
+// Block cache for processors that run from a small fixed code memory, such
+// as the RSP's 4 KB IMEM. Blocks live in a direct-mapped array indexed by
+// physical pc >> 2, so a lookup is one tag compare instead of a hash probe.
+// Slot storage is allocated once and reused, so rewriting and rebuilding
+// microcode does not allocate. Addresses outside the window still work,
+// they just evict whatever shares the slot. Interface matches MipsCache.
+template<typename MipsT, typename TlbType>
+class MipsFlatCache {
+ public:
+  MipsFlatCache();
+  void Reset();
+  void ConnectTlb(TlbType* tlb);
+  MipsCacheBlock<MipsT>* GetBlock(uint64_t address);
+  void InsertBlock(const MipsCacheBlock<MipsT>& block);
+  void InvalidateBlock(uint64_t address);
+  void InvalidateBlockRange(uint64_t start, uint64_t end);
+  void InvalidatePhysicalBlock(uint64_t start);
+  void InvalidatePhysicalRange(uint64_t start, uint64_t end);
+  size_t GetSize() { return size_; };
+  void QueueCacheClear();
+  void ExecuteCacheClear();
+  bool HasPendingWork() const { return has_pending_work_; }
+  std::vector<MipsCacheBlockRecord> ExportBlocks();
+
+  template <typename Func>
+  void ForEachBlock(Func func) {
+    for (int i = 0; i < kFlatCacheSlotCount; i++) {
+      if (tags_[i] != kInvalidTag) {
+        func(*blocks_[i]);
+      }
+    }
+  }
+
+ private:
+  static constexpr uint64_t kInvalidTag = UINT64_MAX;
+
+  static int GetSlot(uint64_t address) {
+    return static_cast<int>((address >> 2) & (kFlatCacheSlotCount - 1));
+  }
+  void InvalidateSlot(int slot);
+
+  // tags_[i] is the physical start of the block in slot i
+  uint64_t tags_[kFlatCacheSlotCount];
+  std::unique_ptr<MipsCacheBlock<MipsT>> blocks_[kFlatCacheSlotCount];
+  size_t size_ = 0;
+  bool has_pending_work_ = false;
+
+  TlbType* tlb_;
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bus_base.h"
+#include "mips_base.h"
+
+struct MipsLockstepDivergence {
+  uint64_t step_;
+  uint64_t inst_retired_;
+  std::string register_name_;
+  uint64_t plain_value_;
+  uint64_t cached_value_;
+};
+
+// Differential checker between the plain interpreter (RunInst) and the cached
+// interpreter (RunCached). Both CPUs are built from the same MipsConfig and
+// run against their own bus, which the caller must set up as identical
+// clones. Each step executes one cached block with RunBlock(), replays the
+// same number of instructions on the plain CPU and compares GPR/HI/LO/PC (and
+// COP0 if has_cop0_ is set). Interrupts and compare are polled on both CPUs
+// at the start of every step and nowhere else, so delivery points match as
+// long as the buses raise interrupts deterministically. Neither the cycle
+// budget nor cpi decides where a step ends.
+template <typename MipsT>
+class MipsLockstep {
+ public:
+  MipsLockstep(MipsConfig config, std::shared_ptr<BusBase> plain_bus, std::shared_ptr<BusBase> cached_bus);
+  void Reset();
+  void SetPc(uint64_t pc);
+  // Returns false once a divergence is found
+  bool Step();
+  // Runs up to max_steps blocks, returns the number of steps completed
+  uint64_t Run(uint64_t max_steps);
+  bool HasDiverged() const { return has_diverged_; }
+  const MipsLockstepDivergence& GetDivergence() const { return divergence_; }
+  void DumpDivergence();
+
+  MipsT& GetPlain() { return *plain_; }
+  MipsT& GetCached() { return *cached_; }
+
+ private:
+  bool Compare();
+  bool CompareValue(const std::string& name, uint64_t plain_value, uint64_t cached_value);
+
+  MipsConfig config_;
+  std::shared_ptr<BusBase> plain_bus_;
+  std::shared_ptr<BusBase> cached_bus_;
+  std::unique_ptr<MipsT> plain_;
+  std::unique_ptr<MipsT> cached_;
+
+  uint64_t step_;
+  uint64_t step_start_pc_;
+  std::vector<uint64_t> step_trace_;
+  bool has_diverged_;
+  MipsLockstepDivergence divergence_;
+};
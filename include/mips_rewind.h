@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "mips_base.h"
+
+// Ring buffer of CPU snapshots taken every interval cycles. Only the newest
+// snapshot is kept in full; every older entry is the XOR against its newer
+// neighbour, run-length encoded. Most of the state is unchanged between
+// captures, so entries are a small fraction of a full snapshot.
+//
+// Only MipsInterface state is captured. Memory and devices behind the bus are
+// not; the owner must bring them to a matching point before calling RunTo().
+class MipsRewindBuffer {
+ public:
+  MipsRewindBuffer(MipsInterface* cpu, int capacity, uint64_t interval);
+  void Reset();
+  // Runs the CPU like MipsInterface::Run, capturing at each interval boundary
+  int Run(int cycle);
+  void Capture();
+  // Restores the newest snapshot at or before timestamp (unless the CPU is
+  // already there) and re-executes forward. Stops at the first block boundary
+  // at or after timestamp. Snapshots newer than the restored one are dropped.
+  bool RunTo(uint64_t timestamp);
+  int GetCount() const { return deltas_.size() + (has_latest_ ? 1 : 0); }
+  uint64_t GetOldestTimestamp() const;
+  size_t GetMemoryUsage() const;
+
+ private:
+  struct Delta {
+    uint64_t timestamp_;
+    std::vector<uint8_t> data_;
+  };
+
+  static void EncodeDelta(const std::vector<uint8_t>& older, const std::vector<uint8_t>& newer,
+                          std::vector<uint8_t>& out);
+  static bool ApplyDelta(const std::vector<uint8_t>& delta, std::vector<uint8_t>& state);
+
+  MipsInterface* cpu_;
+  int capacity_;
+  uint64_t interval_;
+  uint64_t next_capture_;
+
+  bool has_latest_;
+  uint64_t latest_timestamp_;
+  std::vector<uint8_t> latest_;
+  std::vector<uint8_t> scratch_;
+  std::deque<Delta> deltas_;  // Oldest first
+};
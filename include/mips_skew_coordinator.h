@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "bus_base.h"
+#include "mips_base.h"
+
+// Runs several processors (typically N64Mips and RspMips) on their own
+// threads. Time is counted in slices; each processor runs slice_cycles of its
+// own clock per slice, which sets the clock ratio between them. A processor
+// may start a new slice only while it is at most max_skew slices ahead of the
+// slowest other processor.
+//
+// Memory that is only touched through plain loads and stores (RDRAM, DMEM)
+// is accessed without locking, so the bus must tolerate concurrent access
+// there. Buses passed to ConnectBus() call SyncPoint() through
+// BusBase::SyncSharedAccess() before touching shared MMIO. It waits until
+// every other processor has caught up to the start of the caller's current
+// slice. Waiting processors sleep on a condition variable.
+class MipsSkewCoordinator final : public BusSyncHandler {
+ public:
+  MipsSkewCoordinator(int max_skew);
+  // Returns the index of the processor
+  int AddProcessor(MipsInterface* cpu, int slice_cycles);
+  // Makes bus sync with this coordinator before shared MMIO accesses
+  void ConnectBus(BusBase* bus);
+  // Runs every processor for slice_count slices and waits for all of them
+  void Run(uint64_t slice_count);
+  // Called by a bus from a processor thread started by Run(). No-op on any
+  // other thread, so the same bus also works when run single-threaded.
+  void SyncPoint() override;
+
+ private:
+  struct Processor {
+    MipsInterface* cpu_;
+    int slice_cycles_;
+    std::atomic<uint64_t> completed_;
+  };
+
+  void ProcessorMain(int index, uint64_t slice_count);
+  uint64_t GetSlowestOther(int index) const;
+  void SetCompleted(Processor& processor, uint64_t completed);
+  template <typename Predicate>
+  void WaitUntil(Predicate predicate);
+
+  int max_skew_;
+  std::vector<std::unique_ptr<Processor>> processors_;
+  std::mutex mutex_;
+  std::condition_variable progress_;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Flat, host-endian state buffer used by SaveState/LoadState. Components
+// append their fields with Write() and read them back in the same order with
+// Read(). Each component is stored in its own length-prefixed section so a
+// mismatch is detected instead of shifting every following field.
+class MipsStateWriter {
+ public:
+  MipsStateWriter(std::vector<uint8_t>& buffer) : buffer_(buffer) {}
+
+  template <typename T>
+  void Write(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    WriteBytes(&value, sizeof(T));
+  }
+
+  void WriteBytes(const void* data, size_t size) {
+    size_t offset = buffer_.size();
+    buffer_.resize(offset + size);
+    std::memcpy(buffer_.data() + offset, data, size);
+  }
+
+  size_t BeginSection() {
+    size_t offset = buffer_.size();
+    Write<uint32_t>(0);
+    return offset;
+  }
+
+  void EndSection(size_t offset) {
+    uint32_t size = buffer_.size() - offset - sizeof(uint32_t);
+    std::memcpy(buffer_.data() + offset, &size, sizeof(size));
+  }
+
+ private:
+  std::vector<uint8_t>& buffer_;
+};
+
+class MipsStateReader {
+ public:
+  MipsStateReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  template <typename T>
+  bool Read(T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return ReadBytes(&value, sizeof(T));
+  }
+
+  bool ReadBytes(void* data, size_t size) {
+    if (!good_ || size_ - offset_ < size) {
+      good_ = false;
+      return false;
+    }
+    std::memcpy(data, data_ + offset_, size);
+    offset_ += size;
+    return true;
+  }
+
+  // Returns a reader limited to the next section and skips past it
+  MipsStateReader ReadSection() {
+    uint32_t size = 0;
+    if (!Read(size) || size_ - offset_ < size) {
+      good_ = false;
+      MipsStateReader section(nullptr, 0);
+      section.good_ = false;
+      return section;
+    }
+    MipsStateReader section(data_ + offset_, size);
+    offset_ += size;
+    return section;
+  }
+
+  bool IsGood() const { return good_; }
+  bool IsFinished() const { return good_ && offset_ == size_; }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t offset_ = 0;
+  bool good_ = true;
+};
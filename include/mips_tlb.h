@@ -1,6 +1,9 @@
 #pragma once
 #include <cstdint>
 
+class MipsStateWriter;
+class MipsStateReader;
+
 class MipsTlbEntry {
  public:
   MipsTlbEntry() {
@@ -46,4 +49,7 @@ class MipsTlbBase {
   virtual void SetIndex(uint32_t value) = 0;
   virtual void InformTlbException(uint64_t address) = 0;
   virtual uint32_t ProbeTlbEntry() = 0;
+  virtual void SaveState(MipsStateWriter& writer) {}
+  // Same contract as MipsCopBase::LoadState
+  virtual bool LoadState(MipsStateReader& reader, bool commit) { return true; }
 };
\ No newline at end of file
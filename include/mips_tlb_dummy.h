@@ -1,7 +1,7 @@
 #pragma once
 #include "mips_tlb.h"
 
-class MipsTlbDummy : public MipsTlbBase {
+class MipsTlbDummy final : public MipsTlbBase {
  public:
   void Reset() override {};
   MipsTlbTranslationResult TranslateAddress(uint64_t address) override {
@@ -1,11 +1,19 @@
 #pragma once
 #include "mips_tlb.h"
 
-class MipsTlbNormal : public MipsTlbBase {
+class MipsTlbNormal final : public MipsTlbBase {
  public:
   MipsTlbNormal();
   void Reset();
-  MipsTlbTranslationResult TranslateAddress(uint64_t address);
+  // kseg0/kseg1 resolve here so that the common case inlines into the
+  // callers; everything else searches the TLB
+  MipsTlbTranslationResult TranslateAddress(uint64_t address) {
+    address &= 0xFFFFFFFF;
+    if (address >= 0x80000000 && address < 0xC0000000) {
+      return MipsTlbTranslationResult{.found_ = true, .read_only_ = false, .address_ = address & 0x1FFFFFFF};
+    }
+    return TranslateMapped(address);
+  }
   const MipsTlbEntry& GetTlbEntry(int idx);
   void SetTlbEntry(int idx, const MipsTlbEntry& entry);
   uint64_t GetEntryHi();
@@ -20,8 +28,12 @@ class MipsTlbNormal : public MipsTlbBase {
   void SetIndex(uint32_t value);
   void InformTlbException(uint64_t address);
   uint32_t ProbeTlbEntry();
+  void SaveState(MipsStateWriter& writer);
+  bool LoadState(MipsStateReader& reader, bool commit);
 
  private:
+  MipsTlbTranslationResult TranslateMapped(uint64_t address);
+
   MipsTlbEntry entry_[32];
   uint64_t entry_hi_ = 0;
   uint64_t entry_lo0_ = 0;
@@ -2,26 +2,32 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
 #include "mips_cache.h"
 #include "mips_cop0.h"
 #include "mips_cop_dummy.h"
 #include "mips_decode.h"
 #include "mips_fpu.h"
 #include "mips_hook_dummy.h"
+#include "mips_psx_gte.h"
+#include "mips_rsp_vu.h"
+#include "mips_state.h"
 #include "mips_tlb_dummy.h"
 #include "mips_tlb_normal.h"
 #include "panic.h"
 
 #define MIPS_TEMPLATE \
-  template <typename TlbType, bool kIs64Bit, bool kHasLoadDelay, bool kHasCop0>
+  template <typename TlbType, bool kIs64Bit, bool kHasLoadDelay, bool kHasCop0, typename BusType>
 
 #define MIPS_BASE \
-  MipsBase<TlbType, kIs64Bit, kHasLoadDelay, kHasCop0>
+  MipsBase<TlbType, kIs64Bit, kHasLoadDelay, kHasCop0, BusType>
 
 namespace {
 
 const bool kLogCpu = false;
-const bool kEnablePsxSpecific = false;
 const bool kLogKernel = false;
 const bool kPanicOnUnalignedJump = true;
 const bool kLogMipsState = false;
@@ -34,6 +40,53 @@ const uint32_t kPsxKnownNullWritePc[] = {
     0x00000F00, 0xBFC04E90, 0xBFC05164, 0x800585E4,
     0x80059C50, 0x80058788};
 
+const uint32_t kBlockCacheFileMagic = 0x4342474E;  // "NGBC"
+const uint32_t kBlockCacheFileVersion = 1;
+
+struct BlockCacheFileHeader {
+  uint32_t magic_;
+  uint32_t version_;
+  uint32_t cpu_kind_;
+  uint32_t count_;
+};
+
+const uint64_t kNoBreakpointResume = UINT64_MAX;
+
+// OnNewBlock reads instructions in chunks that never cross a page, so one
+// translation covers each chunk
+const int kFetchChunkLength = 16;
+const uint64_t kFetchPageSize = 0x1000;
+
+// Interrupt polling cadence for RunUntil on the uncached path, in instructions
+const int kRunUntilPollInterval = 64;
+
+const uint32_t kStateMagic = 0x534D474E;  // "NGMS"
+const uint32_t kStateVersion = 3;
+// Core, four coprocessors and the TLB
+const int kStateSectionCount = 6;
+
+struct StateHeader {
+  uint32_t magic_;
+  uint32_t version_;
+  uint32_t cpu_kind_;
+  uint32_t cop_kind_;
+  uint32_t section_count_;
+};
+
+// Which coprocessors the config attaches; their sections are only
+// meaningful to a CPU built the same way
+uint32_t get_state_cop_kind(const MipsConfig& config) {
+  return (config.has_fpu_ ? 1 : 0) | (config.has_rsp_vu_ ? 2 : 0) | (config.has_psx_gte_ ? 4 : 0);
+}
+
+// Checks that the buffer is a chain of exactly section_count sections
+bool is_state_layout_valid(MipsStateReader reader, int section_count) {
+  for (int i = 0; i < section_count; i++) {
+    reader.ReadSection();
+  }
+  return reader.IsFinished();
+}
+
 bool get_overflow_add_i32(uint32_t result, uint32_t lhs, uint32_t rhs) {
   return ((lhs ^ result) & (rhs ^ result)) & (1 << 31);
 }
@@ -105,6 +158,149 @@ int32_t sext_itype_imm_branch(ITypeInst inst) {
   return imm;
 }
 
+// Shift that lines the aligned word up with the left-hand (LWL/SWL) part of
+// an unaligned access. The right-hand part uses the complement. Little-endian
+// mirrors the byte offset within the word.
+int unaligned_shamt32(uint64_t address, bool is_big_endian) {
+  int offset = address & 3;
+  return (is_big_endian ? offset : 3 - offset) * 8;
+}
+
+int unaligned_shamt64(uint64_t address, bool is_big_endian) {
+  int offset = address & 7;
+  return (is_big_endian ? offset : 7 - offset) * 8;
+}
+
+// Major opcodes of the halves, checked by the fused handlers
+const uint8_t kOpLdl = 0x1A;
+const uint8_t kOpLwl = 0x22;
+const uint8_t kOpLwr = 0x26;
+
+// Smallest TLB page. Both words of a fused pair that stays inside one share
+// a translation, so only the first can miss.
+const uint64_t kFusedPairPageSize = 4096;
+
+// One half of an LWL/LWR-style load pair
+struct UnalignedHalf {
+  bool is_valid_ = false;
+  bool is_left_ = false;
+  MipsInstId pair_id_ = MipsInstId::kUnknown;  // Identifies the partner, same for both halves
+};
+
+UnalignedHalf get_unaligned_half(uint32_t opcode) {
+  switch (Decode(opcode)) {
+    case MipsInstId::kLwl:
+      return UnalignedHalf{true, true, MipsInstId::kLwl};
+    case MipsInstId::kLwr:
+      return UnalignedHalf{true, false, MipsInstId::kLwl};
+    case MipsInstId::kLdl:
+      return UnalignedHalf{true, true, MipsInstId::kLdl};
+    case MipsInstId::kLdr:
+      return UnalignedHalf{true, false, MipsInstId::kLdl};
+    default:
+      return UnalignedHalf{};
+  }
+}
+
+// Lowest address touched by a fused pair, given either of its halves. The
+// left half holds the low address on big-endian and the high one on
+// little-endian.
+uint64_t get_fused_pair_address(uint64_t rs_value, ITypeInst inst, bool is_left, bool is_big_endian, int width) {
+  uint64_t address = rs_value + sext_itype_imm_i32(inst);
+  return is_left == is_big_endian ? address : address - (width - 1);
+}
+
+bool is_fused_pair_in_page(uint64_t address, int width) {
+  return (address & ~(kFusedPairPageSize - 1)) == ((address + width - 1) & ~(kFusedPairPageSize - 1));
+}
+
+// True if `next`, the instruction in a load's delay slot, reads the register
+// the load writes and so has to see its old value. Branches and LWL/LWR
+// commit pending loads before they run and never see the old value.
+bool reads_load_target(uint32_t load, uint32_t next) {
+  MipsInst load_inst(load);
+  MipsInst next_inst(next);
+  int target = load_inst.GetIType().rt();
+  int rs = next_inst.GetRType().rs();
+  int rt = next_inst.GetRType().rt();
+
+  if (Decode(load) == MipsInstId::kLwc) {
+    // Anything on the same coprocessor may read its registers
+    int cop_id = load_inst.op() & 3;
+    switch (Decode(next)) {
+      case MipsInstId::kCop:
+      case MipsInstId::kMfc:
+      case MipsInstId::kCfc:
+      case MipsInstId::kMtc:
+      case MipsInstId::kCtc:
+      case MipsInstId::kBcf:
+      case MipsInstId::kBct:
+        return (next_inst.op() & 3) == cop_id;
+      case MipsInstId::kSwc:
+        return (next_inst.op() & 3) == cop_id && rt == target;
+      default:
+        return false;
+    }
+  }
+
+  if (target == 0) {
+    return false;
+  }
+  switch (Decode(next)) {
+    case MipsInstId::kBeq:
+    case MipsInstId::kBne:
+    case MipsInstId::kBgtz:
+    case MipsInstId::kBlez:
+    case MipsInstId::kBgez:
+    case MipsInstId::kBgezal:
+    case MipsInstId::kBltz:
+    case MipsInstId::kBltzal:
+    case MipsInstId::kLwl:
+    case MipsInstId::kLwr:
+    case MipsInstId::kJ:
+    case MipsInstId::kJal:
+    case MipsInstId::kLui:
+    case MipsInstId::kMfhi:
+    case MipsInstId::kMflo:
+    case MipsInstId::kMfc:
+    case MipsInstId::kCfc:
+    case MipsInstId::kCop:
+    case MipsInstId::kBcf:
+    case MipsInstId::kBct:
+    case MipsInstId::kSyscall:
+    case MipsInstId::kBreak:
+    case MipsInstId::kNop:
+      return false;
+    case MipsInstId::kMtc:
+    case MipsInstId::kCtc:
+    case MipsInstId::kSll:
+    case MipsInstId::kSra:
+    case MipsInstId::kSrl:
+      return rt == target;
+    case MipsInstId::kAddi:
+    case MipsInstId::kAddiu:
+    case MipsInstId::kAndi:
+    case MipsInstId::kOri:
+    case MipsInstId::kXori:
+    case MipsInstId::kSlti:
+    case MipsInstId::kSltiu:
+    case MipsInstId::kLb:
+    case MipsInstId::kLbu:
+    case MipsInstId::kLh:
+    case MipsInstId::kLhu:
+    case MipsInstId::kLw:
+    case MipsInstId::kLwc:
+    case MipsInstId::kSwc:
+    case MipsInstId::kJr:
+    case MipsInstId::kJalr:
+    case MipsInstId::kMthi:
+    case MipsInstId::kMtlo:
+      return rs == target;
+    default:
+      return rs == target || rt == target;
+  }
+}
+
 }  // namespace
 
 MIPS_TEMPLATE
@@ -126,15 +322,19 @@ MIPS_BASE::MipsBase(MipsConfig config) {
   cycle_spent_ = 0;
   cpi_counter_ = 0;
   cycle_spent_total_ = 0;
+  inst_retired_total_ = 0;
   interrupt_poll_counter_ = 0;
   has_branch_delay_ = false;
   branch_delay_dst_ = 0;
+  delayed_load_op_ = DelayedLoadOp{};
 
   compare_interrupt_ = false;
   cop_cause_ = 0;
 
   halt_ = false;
   mips_log_index_ = 0;
+  inst_mix_.fill(0);
+  breakpoint_resume_pc_ = kNoBreakpointResume;
 
   if constexpr (kHasCop0) {
     cop_[0] = std::make_shared<MipsCop0>();
@@ -146,7 +346,15 @@ MIPS_BASE::MipsBase(MipsConfig config) {
   } else {
     cop_[1] = std::make_shared<MipsCopDummy>();
   }
-  cop_[2] = std::make_shared<MipsCopDummy>();
+  if (config_.has_rsp_vu_) {
+    auto rsp_vu = std::make_shared<MipsRspVu>();
+    rsp_vu_ = rsp_vu.get();
+    cop_[2] = rsp_vu;
+  } else if (config_.has_psx_gte_) {
+    cop_[2] = std::make_shared<MipsPsxGte>(config_.use_fast_gte_);
+  } else {
+    cop_[2] = std::make_shared<MipsCopDummy>();
+  }
   cop_[3] = std::make_shared<MipsCopDummy>();
   for (int i = 0; i < 4; i++) {
     cop_[i]->ConnectCpu(this);
@@ -176,6 +384,7 @@ void MIPS_BASE::Reset() {
   llbit_ = false;
 
   cycle_spent_total_ = 0;
+  inst_retired_total_ = 0;
   cpi_counter_ = 0;
 
   has_branch_delay_ = false;
@@ -184,7 +393,7 @@ void MIPS_BASE::Reset() {
   compare_interrupt_ = false;
   cop_cause_ = 0;
 
-  delayed_load_op_.is_active_ = false;
+  delayed_load_op_ = DelayedLoadOp{};
 
   cache_.Reset();
   halt_ = false;
@@ -246,6 +455,7 @@ int MIPS_BASE::Run(int cycle) {
     return RunCached(cycle);
   }
   cycle_spent_ = 0;
+  debug_stop_ = MipsDebugStop();
   if (!kLazyInterruptPolling) {
     CheckInterrupt();
   }
@@ -261,6 +471,9 @@ int MIPS_BASE::Run(int cycle) {
       }
     }
     RunInst();
+    if (debug_stop_.kind_ != MipsDebugStopKind::kNone) {
+      break;
+    }
   }
   return cycle_spent_;
 }
@@ -268,6 +481,7 @@ int MIPS_BASE::Run(int cycle) {
 MIPS_TEMPLATE
 int MIPS_BASE::RunCached(int cycle) {
   cycle_spent_ = 0;
+  debug_stop_ = MipsDebugStop();
   while (cycle_spent_ < cycle) {
     if constexpr (kHasCop0) {
       if (++interrupt_poll_counter_ >= kInterruptCheckInterval) {
@@ -286,99 +500,340 @@ int MIPS_BASE::RunCached(int cycle) {
       }
     }
 
-    if (cache_.HasPendingWork()) {
-      cache_.ExecuteCacheClear();
+    MipsCacheBlock<MipsBase>* block = GetOrCreateBlock();
+    ExecuteBlock(block, block->length_);
+    if (debug_stop_.kind_ != MipsDebugStopKind::kNone) {
+      break;
     }
+  }
 
-    const MipsCacheBlock<MipsBase>* block = cache_.GetBlock(pc_);
-    if (block == nullptr) {
-      OnNewBlock(pc_);
-      block = cache_.GetBlock(pc_);
-      if (block == nullptr) {
-        PANIC("Block creation failed");
+  return cycle_spent_;
+}
+
+MIPS_TEMPLATE
+int MIPS_BASE::RunBlock() {
+  cycle_spent_ = 0;
+  debug_stop_ = MipsDebugStop();
+  if (halt_) {
+    return 0;
+  }
+  MipsCacheBlock<MipsBase>* block = GetOrCreateBlock();
+  return ExecuteBlock(block, block->length_);
+}
+
+MIPS_TEMPLATE
+MipsStopReason MIPS_BASE::RunUntil(const MipsRunCondition& condition) {
+  debug_stop_ = MipsDebugStop();
+  if (config_.use_cached_interpreter_) {
+    return RunUntilCached(condition);
+  }
+  return RunUntilUncached(condition);
+}
+
+MIPS_TEMPLATE
+MipsStopReason MIPS_BASE::RunUntilCached(const MipsRunCondition& condition) {
+  std::vector<uint64_t> stop_pcs;
+  for (uint64_t stop_pc : condition.stop_pcs_) {
+    stop_pcs.push_back(stop_pc & 0xFFFFFFFF);
+  }
+  std::sort(stop_pcs.begin(), stop_pcs.end());
+
+  cycle_spent_ = 0;
+  bool is_first_block = true;
+  while (true) {
+    if constexpr (kHasCop0) {
+      if (++interrupt_poll_counter_ >= kInterruptCheckInterval) {
+        interrupt_poll_counter_ = 0;
+        CheckInterrupt();
+        CheckCompare();
+      }
+    }
+    if (cycle_spent_total_ >= condition.deadline_) {
+      return MipsStopReason::kDeadline;
+    }
+    if (halt_) {
+      // Like Run, a halted CPU lets time pass until the deadline
+      if (condition.deadline_ == UINT64_MAX) {
+        return MipsStopReason::kHalt;
       }
+      cycle_spent_total_ = condition.deadline_;
+      return MipsStopReason::kDeadline;
+    }
+    if (!is_first_block && condition.predicate_ && condition.predicate_(*this)) {
+      return MipsStopReason::kPredicate;
     }
 
-    const int length = block->length_;
+    MipsCacheBlock<MipsBase>* block = GetOrCreateBlock();
     const MipsCacheEntry<MipsBase>* entries = block->entries_;
-
-    int executed = 0;
-    for (int i = 0; i < length; i++) {
-      // If a previous instruction (exception, branch-likely nullification)
-      // changed PC to outside this block, stop executing the block
-      if (i > 0 && pc_ != entries[i].address_) {
-        break;
+    int limit = block->length_;
+
+    // Entries are consecutive, so a stop PC inside the block is found with
+    // one search. The first instruction of the call is allowed to run.
+    bool stops_at_pc = false;
+    if (!stop_pcs.empty()) {
+      uint64_t first = entries[0].address_ + (is_first_block ? 4 : 0);
+      uint64_t last = entries[block->length_ - 1].address_;
+      auto found = std::lower_bound(stop_pcs.begin(), stop_pcs.end(), first);
+      if (found != stop_pcs.end() && *found <= last && (*found & 3) == 0) {
+        limit = (*found - entries[0].address_) / 4;
+        stops_at_pc = true;
       }
+    }
+    if (limit == 0) {
+      return MipsStopReason::kPc;
+    }
 
-      const uint32_t opcode = entries[i].opcode_;
-      const uint32_t pc = entries[i].address_;
-      const inst_ptr_t fp = entries[i].func_;
-
-      MipsLog log;
-      if (kLogCpu || kLogMipsState) {
-        log.pc_ = pc_;
-        log.inst_ = opcode;
-        for (int i = 0; i < 32; i++) {
-          log.gpr_[i] = ReadGpr64(i);
-        }
+    bool stops_at_deadline = false;
+    if (condition.deadline_ != UINT64_MAX) {
+      int inst_count = GetInstCountUntil(condition.deadline_);
+      if (inst_count < limit) {
+        limit = inst_count;
+        stops_at_pc = false;
+        stops_at_deadline = true;
       }
+    }
 
-      if (kLogMipsState) {
-        mips_log_[mips_log_index_] = log;
-        mips_log_index_++;
-        if (mips_log_index_ >= kMipsInstLogCount) {
-          mips_log_index_ = 0;
-        }
+    // Stopping between the halves of a fused pair would load both and then
+    // run the second again at the start of the next block. Stop before the
+    // pair instead and run its first half on its own.
+    bool splits_fused_pair = limit < block->length_ && entries[limit].func_ == &MipsBase::InstFusedSecondHalf;
+    int executed = ExecuteBlock(block, splits_fused_pair ? limit - 1 : limit);
+    if (splits_fused_pair && executed == limit - 1 && pc_ == entries[limit - 1].address_ &&
+        debug_stop_.kind_ == MipsDebugStopKind::kNone) {
+      RunInst();
+      executed++;
+    }
+    is_first_block = false;
+    if (debug_stop_.kind_ != MipsDebugStopKind::kNone) {
+      return GetDebugStopReason();
+    }
+    if (executed == limit && limit < block->length_) {
+      if (stops_at_pc && pc_ == entries[limit].address_) {
+        return MipsStopReason::kPc;
       }
+      if (stops_at_deadline) {
+        return MipsStopReason::kDeadline;
+      }
+    }
+  }
+}
 
-      if (kLogCpu) {
-        fmt::print("{}\n", log.ToString(kIs64Bit));
+MIPS_TEMPLATE
+MipsStopReason MIPS_BASE::RunUntilUncached(const MipsRunCondition& condition) {
+  std::vector<uint64_t> stop_pcs;
+  for (uint64_t stop_pc : condition.stop_pcs_) {
+    stop_pcs.push_back(stop_pc & 0xFFFFFFFF);
+  }
+  std::sort(stop_pcs.begin(), stop_pcs.end());
+
+  cycle_spent_ = 0;
+  int poll_counter = 0;
+  bool is_first_inst = true;
+  while (true) {
+    if (poll_counter-- <= 0) {
+      poll_counter = kRunUntilPollInterval;
+      CheckInterrupt();
+      CheckCompare();
+    }
+    if (cycle_spent_total_ >= condition.deadline_) {
+      return MipsStopReason::kDeadline;
+    }
+    if (halt_) {
+      if (condition.deadline_ == UINT64_MAX) {
+        return MipsStopReason::kHalt;
       }
+      cycle_spent_total_ = condition.deadline_;
+      return MipsStopReason::kDeadline;
+    }
+    if (!is_first_inst && std::binary_search(stop_pcs.begin(), stop_pcs.end(), pc_ & 0xFFFFFFFF)) {
+      return MipsStopReason::kPc;
+    }
 
-      if (config_.use_hook_) {
-        for (auto& hook : hook_) {
-          hook->OnPreExecute(pc_, opcode);
-        }
+    bool ends_block = has_branch_delay_;
+    RunInst();
+    is_first_inst = false;
+    if (debug_stop_.kind_ != MipsDebugStopKind::kNone) {
+      return GetDebugStopReason();
+    }
+    if (ends_block && condition.predicate_ && condition.predicate_(*this)) {
+      return MipsStopReason::kPredicate;
+    }
+  }
+}
+
+MIPS_TEMPLATE
+int MIPS_BASE::GetInstCountUntil(uint64_t timestamp) {
+  // Smallest instruction count that brings the timestamp to the deadline,
+  // given the fractional cycles already accumulated in cpi_counter_
+  if (cycle_spent_total_ >= timestamp) {
+    return 0;
+  }
+  uint64_t remaining = std::min<uint64_t>(timestamp - cycle_spent_total_, 1ULL << 40);
+  int64_t needed = static_cast<int64_t>(remaining << 8) - cpi_counter_;
+  int64_t inst_count = (needed + config_.cpi_ - 1) / config_.cpi_;
+  return std::min<int64_t>(inst_count, kCacheBlockMaxLength + 1);
+}
+
+MIPS_TEMPLATE
+MipsCacheBlock<MIPS_BASE>* MIPS_BASE::GetOrCreateBlock() {
+  if (cache_.HasPendingWork()) {
+    cache_.ExecuteCacheClear();
+  }
+
+  MipsCacheBlock<MipsBase>* block = cache_.GetBlock(pc_);
+  if (block != nullptr && block->state_epoch_ != state_epoch_) {
+    block = RevalidateBlock(block);
+  }
+  if (block == nullptr) {
+    OnNewBlock(pc_);
+    block = cache_.GetBlock(pc_);
+    if (block == nullptr) {
+      PANIC("Block creation failed");
+    }
+  }
+  return block;
+}
+
+MIPS_TEMPLATE
+int MIPS_BASE::ExecuteBlock(MipsCacheBlock<MipsBase>* block, int limit) {
+  const MipsCacheEntry<MipsBase>* entries = block->entries_;
+
+  int executed;
+  if constexpr (kHasLoadDelay) {
+    // ResolveLoadDelays leaves a load pending only when the next instruction
+    // reads its target, or when the load is the last entry. Only blocks with
+    // such a hazard, or that start in the delay slot of the previous block's
+    // last load, commit pending loads after every instruction.
+    if (block->has_load_hazard_ || delayed_load_op_.is_active_) {
+      executed = ExecuteEntries<true>(entries, limit);
+    } else {
+      executed = ExecuteEntries<false>(entries, limit);
+      // Advances a load queued by the last entry, which then lands after the
+      // next block's first instruction
+      ExecuteDelayedLoad();
+    }
+  } else {
+    executed = ExecuteEntries<false>(entries, limit);
+  }
+
+  if (kEnablePsxSpecific) {
+    CheckHook();
+  }
+
+  inst_retired_total_ += executed;
+  cpi_counter_ += executed * config_.cpi_;
+  int cpi_integer = cpi_counter_ >> 8;
+  cpi_counter_ &= 0xFF;
+  cycle_spent_ += cpi_integer;
+  cycle_spent_total_ += cpi_integer;
+
+  if constexpr (kEnableInstMix) {
+    for (int i = 0; i < executed; i++) {
+      inst_mix_[static_cast<int>(Decode(entries[i].opcode_))]++;
+    }
+  }
+
+  if constexpr (kEnableBlockProfiler) {
+    block->profile_.entries_++;
+    block->profile_.inst_retired_ += executed;
+    block->profile_.early_exits_ += executed < block->length_ ? 1 : 0;
+    block->profile_.cycles_ += cpi_integer;
+  }
+  return executed;
+}
+
+MIPS_TEMPLATE
+template <bool kTracksLoadDelay>
+int MIPS_BASE::ExecuteEntries(const MipsCacheEntry<MipsBase>* entries, int limit) {
+  const int length = limit;
+
+  int executed = 0;
+  for (int i = 0; i < length; i++) {
+    // If a previous instruction (exception, branch-likely nullification)
+    // changed PC to outside this block, stop executing the block
+    if (i > 0 && pc_ != entries[i].address_) {
+      break;
+    }
+
+    const uint32_t opcode = entries[i].opcode_;
+    const uint32_t pc = entries[i].address_;
+    const inst_ptr_t fp = entries[i].func_;
+
+    MipsLog log;
+    if (kLogCpu || kLogMipsState) {
+      log.pc_ = pc_;
+      log.inst_ = opcode;
+      for (int i = 0; i < 32; i++) {
+        log.gpr_[i] = ReadGpr64(i);
       }
+    }
 
-      if (has_branch_delay_) {
-        next_pc_ = branch_delay_dst_;
-        has_branch_delay_ = false;
-      } else {
-        next_pc_ = pc_ + 4;
+    if (kLogMipsState) {
+      mips_log_[mips_log_index_] = log;
+      mips_log_index_++;
+      if (mips_log_index_ >= kMipsInstLogCount) {
+        mips_log_index_ = 0;
       }
+    }
+
+    if (kLogCpu) {
+      fmt::print("{}\n", log.ToString(kIs64Bit));
+    }
 
-      (this->*fp)(opcode);
-      if constexpr (kHasLoadDelay) {
-        ExecuteDelayedLoad();
+    if (config_.use_hook_) {
+      for (auto& hook : hook_) {
+        hook->OnPreExecute(pc_, opcode);
       }
+    }
 
-      pc_ = next_pc_ & 0xFFFFFFFF;
-      executed++;
+    if (has_branch_delay_) {
+      next_pc_ = branch_delay_dst_;
+      has_branch_delay_ = false;
+    } else {
+      next_pc_ = pc_ + 4;
     }
 
-    if (kEnablePsxSpecific) {
-      CheckHook();
+    (this->*fp)(opcode);
+    if constexpr (kTracksLoadDelay) {
+      ExecuteDelayedLoad();
     }
 
-    cpi_counter_ += executed * config_.cpi_;
-    int cpi_integer = cpi_counter_ >> 8;
-    cpi_counter_ &= 0xFF;
-    cycle_spent_ += cpi_integer;
-    cycle_spent_total_ += cpi_integer;
+    pc_ = next_pc_ & 0xFFFFFFFF;
+    executed++;
   }
-
-  return cycle_spent_;
+  return executed;
 }
 
 MIPS_TEMPLATE
 void MIPS_BASE::ConnectCop(std::shared_ptr<MipsCopBase> cop, int idx) {
   cop_[idx] = cop;
+  if (idx == 2) {
+    // Blocks hold handlers bound to the old vector unit, if any
+    MipsRspVu* rsp_vu = dynamic_cast<MipsRspVu*>(cop.get());
+    if (rsp_vu != rsp_vu_) {
+      rsp_vu_ = rsp_vu;
+      cache_.QueueCacheClear();
+    }
+    if (rsp_vu_ != nullptr) {
+      rsp_vu_->ConnectBus(bus_.get());
+    }
+  }
 }
 
 MIPS_TEMPLATE
 void MIPS_BASE::ConnectBus(std::shared_ptr<BusBase> bus) {
-  bus_ = bus;
+  if constexpr (std::is_same_v<BusType, BusBase>) {
+    bus_ = bus;
+  } else {
+    bus_ = std::dynamic_pointer_cast<BusType>(bus);
+    if (bus_ == nullptr && bus != nullptr) {
+      PANIC("Bus does not match the type this CPU was instantiated with");
+    }
+  }
+  has_fast_fetch_block_ = bus_ != nullptr && bus_->HasFastFetchBlock();
+  if (rsp_vu_ != nullptr) {
+    rsp_vu_->ConnectBus(bus_.get());
+  }
 }
 
 MIPS_TEMPLATE
@@ -390,6 +845,7 @@ MIPS_TEMPLATE
 void MIPS_BASE::SetPc(uint64_t pc) {
   pc_ = pc;
   next_pc_ = pc + 4;
+  breakpoint_resume_pc_ = kNoBreakpointResume;
 }
 
 MIPS_TEMPLATE
@@ -488,7 +944,7 @@ void MIPS_BASE::CheckInterrupt() {
     // If we enable lazy polling, this function will be called in the middle of instruction
     // Solution: we run instruction clean-up manually (aka. a dirty hack)
     if (cpu_intr_enabled && intr_pending) {
-      pc_ = next_pc_;
+      pc_ = next_pc_ & 0xFFFFFFFF;
       cpi_counter_ += config_.cpi_;
       int cpi_integer = cpi_counter_ >> 8;
       cpi_counter_ &= 0xFF;
@@ -506,6 +962,16 @@ void MIPS_BASE::CheckInterrupt() {
 
 MIPS_TEMPLATE
 void MIPS_BASE::RunInst() {
+  if (!breakpoints_.empty() && breakpoints_.contains(pc_ & 0xFFFFFFFF)) {
+    if (pc_ != breakpoint_resume_pc_) {
+      debug_stop_.kind_ = MipsDebugStopKind::kBreakpoint;
+      debug_stop_.pc_ = pc_;
+      breakpoint_resume_pc_ = pc_;
+      return;
+    }
+    breakpoint_resume_pc_ = kNoBreakpointResume;
+  }
+
   uint32_t opcode = Fetch(pc_);
   bool is_this_inst_bd = has_branch_delay_;
   if (has_branch_delay_) {
@@ -545,11 +1011,16 @@ void MIPS_BASE::RunInst() {
   inst_ptr_t fp = GetInstFuncPtr(opcode);
   (this->*fp)(opcode);
 
+  if constexpr (kEnableInstMix) {
+    inst_mix_[static_cast<int>(Decode(opcode))]++;
+  }
+
   if constexpr (kHasLoadDelay) {
     ExecuteDelayedLoad();
   }
 
-  pc_ = next_pc_;
+  pc_ = next_pc_ & 0xFFFFFFFF;
+  inst_retired_total_++;
   cpi_counter_ += config_.cpi_;
   int cpi_integer = cpi_counter_ >> 8;
   cpi_counter_ &= 0xFF;
@@ -563,6 +1034,13 @@ void MIPS_BASE::RunInst() {
 
 MIPS_TEMPLATE
 auto MIPS_BASE::GetInstFuncPtr(uint32_t opcode) -> inst_ptr_t {
+  if (rsp_vu_ != nullptr) {
+    inst_ptr_t vu_func = GetVuFuncPtr(opcode);
+    if (vu_func != nullptr) {
+      return vu_func;
+    }
+  }
+
   switch (Decode(opcode)) {
     case MipsInstId::kAdd:
       return &MipsBase::InstAdd;
@@ -649,21 +1127,21 @@ auto MIPS_BASE::GetInstFuncPtr(uint32_t opcode) -> inst_ptr_t {
     case MipsInstId::kBreak:
       return &MipsBase::InstBreak;
     case MipsInstId::kLb:
-      return &MipsBase::InstLb;
+      return &MipsBase::InstLb<true>;
     case MipsInstId::kLbu:
-      return &MipsBase::InstLbu;
+      return &MipsBase::InstLbu<true>;
     case MipsInstId::kLh:
-      return &MipsBase::InstLh;
+      return &MipsBase::InstLh<true>;
     case MipsInstId::kLhu:
-      return &MipsBase::InstLhu;
+      return &MipsBase::InstLhu<true>;
     case MipsInstId::kLw:
-      return &MipsBase::InstLw;
+      return &MipsBase::InstLw<true>;
     case MipsInstId::kLwl:
       return &MipsBase::InstLwl;
     case MipsInstId::kLwr:
       return &MipsBase::InstLwr;
     case MipsInstId::kLwc:
-      return &MipsBase::InstLwc;
+      return &MipsBase::InstLwc<true>;
     case MipsInstId::kSb:
       return &MipsBase::InstSb;
     case MipsInstId::kSh:
@@ -790,6 +1268,180 @@ auto MIPS_BASE::GetInstFuncPtr(uint32_t opcode) -> inst_ptr_t {
   return &MipsBase::InstUnknown;
 }
 
+MIPS_TEMPLATE
+auto MIPS_BASE::GetVuFuncPtr(uint32_t opcode) -> inst_ptr_t {
+  // Resolved once per opcode, so a cached vector op calls its lane kernel
+  // directly instead of going through Command()
+  switch (opcode >> 26) {
+    case 0x12:
+      if (!(opcode & (1 << 25))) {
+        switch ((opcode >> 21) & 0x1F) {
+          case 0x00:
+            return &MipsBase::InstVuMfc;
+          case 0x02:
+            return &MipsBase::InstVuCfc;
+          case 0x04:
+            return &MipsBase::InstVuMtc;
+          case 0x06:
+            return &MipsBase::InstVuCtc;
+          default:
+            return nullptr;
+        }
+      }
+      switch (opcode & 0x3F) {
+        case 0x00:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmulf>;
+        case 0x01:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmulu>;
+        case 0x02:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVrndp>;
+        case 0x03:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmulq>;
+        case 0x04:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmudl>;
+        case 0x05:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmudm>;
+        case 0x06:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmudn>;
+        case 0x07:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmudh>;
+        case 0x08:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmacf>;
+        case 0x09:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmacu>;
+        case 0x0A:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVrndn>;
+        case 0x0B:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmacq>;
+        case 0x0C:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmadl>;
+        case 0x0D:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmadm>;
+        case 0x0E:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmadn>;
+        case 0x0F:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmadh>;
+        case 0x10:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVadd>;
+        case 0x11:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVsub>;
+        case 0x13:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVabs>;
+        case 0x14:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVaddc>;
+        case 0x15:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVsubc>;
+        case 0x1D:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVsar>;
+        case 0x20:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVlt>;
+        case 0x21:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVeq>;
+        case 0x22:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVne>;
+        case 0x23:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVge>;
+        case 0x24:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVcl>;
+        case 0x25:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVch>;
+        case 0x26:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVcr>;
+        case 0x27:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmrg>;
+        case 0x28:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVand>;
+        case 0x29:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVnand>;
+        case 0x2A:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVor>;
+        case 0x2B:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVnor>;
+        case 0x2C:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVxor>;
+        case 0x2D:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVnxor>;
+        case 0x30:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVrcp>;
+        case 0x31:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVrcpl>;
+        case 0x32:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVrcph>;
+        case 0x33:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVmov>;
+        case 0x34:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVrsq>;
+        case 0x35:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVrsql>;
+        case 0x36:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVrsqh>;
+        case 0x37:
+        case 0x3F:
+          return &MipsBase::InstNop;
+        default:
+          return &MipsBase::InstVuCompute<&MipsRspVu::InstVzero>;
+      }
+    case 0x32:
+      switch ((opcode >> 11) & 0x1F) {
+        case 0x00:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstLbv>;
+        case 0x01:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstLsv>;
+        case 0x02:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstLlv>;
+        case 0x03:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstLdv>;
+        case 0x04:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstLqv>;
+        case 0x05:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstLrv>;
+        case 0x06:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstLpv>;
+        case 0x07:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstLuv>;
+        case 0x08:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstLhv>;
+        case 0x09:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstLfv>;
+        case 0x0B:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstLtv>;
+        default:
+          return &MipsBase::InstNop;
+      }
+    case 0x3A:
+      switch ((opcode >> 11) & 0x1F) {
+        case 0x00:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstSbv>;
+        case 0x01:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstSsv>;
+        case 0x02:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstSlv>;
+        case 0x03:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstSdv>;
+        case 0x04:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstSqv>;
+        case 0x05:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstSrv>;
+        case 0x06:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstSpv>;
+        case 0x07:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstSuv>;
+        case 0x08:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstShv>;
+        case 0x09:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstSfv>;
+        case 0x0A:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstSwv>;
+        case 0x0B:
+          return &MipsBase::InstVuMemory<&MipsRspVu::InstStv>;
+        default:
+          return &MipsBase::InstNop;
+      }
+    default:
+      return nullptr;
+  }
+}
+
 MIPS_TEMPLATE
 uint32_t MIPS_BASE::ReadGpr32(int idx) {
   return gpr_[idx];
@@ -879,12 +1531,9 @@ void MIPS_BASE::QueueDelayedLoad(int dst, uint64_t value) {
     return;
   }
   if (delayed_load_op_.is_active_) {
-    if constexpr (kHasLoadDelay) {
-      ExecuteDelayedLoad();
-    }
-    if (delayed_load_op_.is_active_) {
-      PANIC("Consecutive loads not handled");
-    }
+    // This instruction is the pending load's delay slot and has already
+    // read its operands, so the older value lands first
+    CommitDelayedLoad();
   }
   /* Load delay is only in MIPS I. So only lower 32-bit of the passed value is relevant */
   delayed_load_op_.is_active_ = true;
@@ -901,12 +1550,7 @@ void MIPS_BASE::QueueDelayedCopLoad(int cop_id, int dst, uint64_t value) {
     return;
   }
   if (delayed_load_op_.is_active_) {
-    if constexpr (kHasLoadDelay) {
-      ExecuteDelayedLoad();
-    }
-    if (delayed_load_op_.is_active_) {
-      PANIC("Consecutive loads not handled");
-    }
+    CommitDelayedLoad();
   }
   delayed_load_op_.is_active_ = true;
   delayed_load_op_.delay_counter_ = 0;
@@ -925,7 +1569,11 @@ void MIPS_BASE::ExecuteDelayedLoad() {
   if (delayed_load_op_.delay_counter_ != 2) {
     return;
   }
+  CommitDelayedLoad();
+}
 
+MIPS_TEMPLATE
+void MIPS_BASE::CommitDelayedLoad() {
   if (delayed_load_op_.cop_id_ < 0) {
     WriteGpr32(delayed_load_op_.dst_, delayed_load_op_.value_);
   } else {
@@ -941,6 +1589,31 @@ void MIPS_BASE::ExecuteDelayedLoad() {
   delayed_load_op_.delay_counter_ = 0;
 }
 
+MIPS_TEMPLATE
+template <bool kIsDelayed>
+void MIPS_BASE::CompleteLoad(int dst, uint64_t value) {
+  if constexpr (kIsDelayed) {
+    QueueDelayedLoad(dst, value);
+  } else {
+    WriteGpr32(dst, value);
+  }
+}
+
+MIPS_TEMPLATE
+template <bool kIsDelayed>
+void MIPS_BASE::CompleteCopLoad(int cop_id, int dst, uint64_t value) {
+  if constexpr (kIsDelayed) {
+    QueueDelayedCopLoad(cop_id, dst, value);
+  } else {
+    cop_[cop_id]->Write32(dst, value);
+    if (kLazyInterruptPolling) {
+      if (cop_id == 0) {
+        CheckInterrupt();
+      }
+    }
+  }
+}
+
 MIPS_TEMPLATE
 void MIPS_BASE::TriggerException(ExceptionCause cause) {
   if (!config_.has_exception_) {
@@ -1090,11 +1763,83 @@ void MIPS_BASE::DumpProcessorLog() {
 }
 
 MIPS_TEMPLATE
-uint32_t MIPS_BASE::Fetch(uint64_t address) {
-  MipsTlbTranslationResult tlb_result = tlb_.TranslateAddress(address);
-  if (!tlb_result.found_) {
-    cop_[0]->Write64Internal(8, address);
-    tlb_.InformTlbException(address);
+void MIPS_BASE::DumpHotBlocks(int count) {
+  if (!kEnableBlockProfiler) {
+    fmt::print("Block profiler is disabled (build with NGMIPS_BLOCK_PROFILER)\n");
+    return;
+  }
+
+  std::vector<const MipsCacheBlock<MipsBase>*> blocks;
+  uint64_t cycles_total = 0;
+  cache_.ForEachBlock([&](const MipsCacheBlock<MipsBase>& block) {
+    if (block.profile_.entries_ != 0) {
+      blocks.push_back(&block);
+      cycles_total += block.profile_.cycles_;
+    }
+  });
+
+  count = std::min<int>(count, blocks.size());
+  std::partial_sort(blocks.begin(), blocks.begin() + count, blocks.end(),
+                    [](const auto* lhs, const auto* rhs) { return lhs->profile_.cycles_ > rhs->profile_.cycles_; });
+
+  std::string processor_name = kHasCop0 ? "CPU" : "RSP";
+  fmt::print("===== Hot blocks ({}) =====\n", processor_name);
+  for (int i = 0; i < count; i++) {
+    const MipsCacheBlock<MipsBase>& block = *blocks[i];
+    const MipsCacheBlockProfile& profile = block.profile_;
+    double share = cycles_total != 0 ? 100.0 * profile.cycles_ / cycles_total : 0.0;
+    fmt::print("#{} {:08X} (phys {:08X}) | {:.2f}% | cycles: {} | entries: {} | inst: {} | early exits: {}\n",
+               i, block.entries_[0].address_, block.start_, share, profile.cycles_,
+               profile.entries_, profile.inst_retired_, profile.early_exits_);
+    for (int j = 0; j < block.length_; j++) {
+      const MipsCacheEntry<MipsBase>& entry = block.entries_[j];
+      fmt::print("  {:08X} | {}\n", entry.address_, MipsInst(entry.opcode_).Disassemble(entry.address_));
+    }
+  }
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::ResetBlockProfile() {
+  cache_.ForEachBlock([](MipsCacheBlock<MipsBase>& block) {
+    block.profile_ = MipsCacheBlockProfile();
+  });
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::DumpInstMix(int count) {
+  if (!kEnableInstMix) {
+    fmt::print("Instruction mix counters are disabled (build with NGMIPS_INST_MIX)\n");
+    return;
+  }
+
+  uint64_t total = 0;
+  int ranked[kMipsInstIdCount];
+  for (int i = 0; i < kMipsInstIdCount; i++) {
+    ranked[i] = i;
+    total += inst_mix_[i];
+  }
+  std::sort(ranked, ranked + kMipsInstIdCount, [this](int lhs, int rhs) { return inst_mix_[lhs] > inst_mix_[rhs]; });
+
+  std::string processor_name = kHasCop0 ? "CPU" : "RSP";
+  fmt::print("===== Instruction mix ({}, {} executed) =====\n", processor_name, total);
+  double cumulative = 0.0;
+  for (int i = 0; i < std::min(count, kMipsInstIdCount); i++) {
+    uint64_t executed = inst_mix_[ranked[i]];
+    if (executed == 0) {
+      break;
+    }
+    double share = 100.0 * executed / total;
+    cumulative += share;
+    fmt::print("{:>3} {:<10} {:>14} | {:6.2f}% | {:6.2f}%\n", i, GetInstIdName(static_cast<MipsInstId>(ranked[i])), executed, share, cumulative);
+  }
+}
+
+MIPS_TEMPLATE
+uint32_t MIPS_BASE::Fetch(uint64_t address) {
+  MipsTlbTranslationResult tlb_result = tlb_.TranslateAddress(address);
+  if (!tlb_result.found_) {
+    cop_[0]->Write64Internal(8, address);
+    tlb_.InformTlbException(address);
     TriggerException(ExceptionCause::kTlbMissLoad);
     return 0;
   }
@@ -1125,6 +1870,9 @@ LoadResult8 MIPS_BASE::Load8(uint64_t address) {
     DumpProcessorLog();
     PANIC("Load from unmapped address");
   }
+  if (watch_pages_ != nullptr) {
+    CheckWatchpoint(tlb_result.address_, 1, false, result.value);
+  }
   return result;
 }
 
@@ -1150,6 +1898,9 @@ LoadResult16 MIPS_BASE::Load16(uint64_t address) {
     DumpProcessorLog();
     PANIC("Load from unmapped address");
   }
+  if (watch_pages_ != nullptr) {
+    CheckWatchpoint(tlb_result.address_, 2, false, result.value);
+  }
   return result;
 }
 
@@ -1175,6 +1926,9 @@ LoadResult32 MIPS_BASE::Load32(uint64_t address) {
     DumpProcessorLog();
     PANIC("Load from unmapped address");
   }
+  if (watch_pages_ != nullptr) {
+    CheckWatchpoint(tlb_result.address_, 4, false, result.value);
+  }
   return result;
 }
 
@@ -1200,6 +1954,67 @@ LoadResult64 MIPS_BASE::Load64(uint64_t address) {
     DumpProcessorLog();
     PANIC("Load from unmapped address");
   }
+  if (watch_pages_ != nullptr) {
+    CheckWatchpoint(tlb_result.address_, 8, false, result.value);
+  }
+  return result;
+}
+
+MIPS_TEMPLATE
+LoadResult32 MIPS_BASE::LoadAligned32(uint64_t address) {
+  MipsTlbTranslationResult tlb_result = tlb_.TranslateAddress(address);
+  if (!tlb_result.found_) {
+    cop_[0]->Write64Internal(8, address);
+    tlb_.InformTlbException(address);
+    TriggerException(ExceptionCause::kTlbMissLoad);
+    return LoadResult32{.has_value = false, .value = 0};
+  }
+
+  if (config_.use_hook_) {
+    for (auto& hook : hook_) {
+      hook->OnLoad32(address & ~3ULL);
+    }
+  }
+
+  uint64_t physical_aligned = tlb_result.address_ & ~3ULL;
+  LoadResult32 result = bus_->Load32(physical_aligned);
+  if (!result.has_value) {
+    fmt::print("PC: {:08X} | Load from unmapped address: {:08X}\n", pc_, address & 0xFFFFFFFF);
+    DumpProcessorLog();
+    PANIC("Load from unmapped address");
+  }
+  if (watch_pages_ != nullptr) {
+    CheckWatchpoint(physical_aligned, 4, false, result.value);
+  }
+  return result;
+}
+
+MIPS_TEMPLATE
+LoadResult64 MIPS_BASE::LoadAligned64(uint64_t address) {
+  MipsTlbTranslationResult tlb_result = tlb_.TranslateAddress(address);
+  if (!tlb_result.found_) {
+    cop_[0]->Write64Internal(8, address);
+    tlb_.InformTlbException(address);
+    TriggerException(ExceptionCause::kTlbMissLoad);
+    return LoadResult64{.has_value = false, .value = 0};
+  }
+
+  if (config_.use_hook_) {
+    for (auto& hook : hook_) {
+      hook->OnLoad64(address & ~7ULL);
+    }
+  }
+
+  uint64_t physical_aligned = tlb_result.address_ & ~7ULL;
+  LoadResult64 result = bus_->Load64(physical_aligned);
+  if (!result.has_value) {
+    fmt::print("PC: {:08X} | Load from unmapped address: {:08X}\n", pc_, address & 0xFFFFFFFF);
+    DumpProcessorLog();
+    PANIC("Load from unmapped address");
+  }
+  if (watch_pages_ != nullptr) {
+    CheckWatchpoint(physical_aligned, 8, false, result.value);
+  }
   return result;
 }
 
@@ -1245,6 +2060,9 @@ void MIPS_BASE::Store8(uint64_t address, uint8_t value) {
     }
   }
 
+  if (watch_pages_ != nullptr) {
+    CheckWatchpoint(tlb_result.address_, 1, true, value);
+  }
   bus_->Store8(tlb_result.address_, value);
   if (config_.use_cached_interpreter_) {
     // InvalidateBlock(address);
@@ -1291,148 +2109,710 @@ void MIPS_BASE::Store16(uint64_t address, uint16_t value) {
     for (auto& hook : hook_) {
       hook->OnStore16(address, value);
     }
-  }
+  }
+
+  if (watch_pages_ != nullptr) {
+    CheckWatchpoint(tlb_result.address_, 2, true, value);
+  }
+  bus_->Store16(tlb_result.address_, value);
+  if (config_.use_cached_interpreter_) {
+    // InvalidateBlock(address);
+  }
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::Store32(uint64_t address, uint32_t value) {
+  if (config_.has_isolate_cache_bit_ && (cop_[0]->Read32Internal(12) & (1 << 16))) {
+    return;
+  }
+
+  MipsTlbTranslationResult tlb_result = tlb_.TranslateAddress(address);
+  if (!tlb_result.found_) {
+    cop_[0]->Write64Internal(8, address);
+    tlb_.InformTlbException(address);
+    TriggerException(ExceptionCause::kTlbMissStore);
+    return;
+  }
+  if (tlb_result.read_only_) {
+    cop_[0]->Write64Internal(8, address);
+    tlb_.InformTlbException(address);
+    TriggerException(ExceptionCause::kTlbMod);
+    return;
+  }
+
+  if (kLogNullWrites || kPanicOnNullWrites) {
+    if (address == 0 || address == 0x80000000 || address == 0xA0000000) {
+      bool is_pc_known = false;
+      for (auto known_pc : kPsxKnownNullWritePc) {
+        is_pc_known |= pc_ == known_pc;
+      }
+      if (!is_pc_known) {
+        fmt::print("PC:{:08X} | [NULL] <- {:08X}\n", pc_, value);
+        if (kPanicOnNullWrites) {
+          DumpProcessorLog();
+          PANIC("Null write");
+        }
+      }
+    }
+  }
+
+  if (config_.use_hook_) {
+    for (auto& hook : hook_) {
+      hook->OnStore32(address, value);
+    }
+  }
+
+  if (watch_pages_ != nullptr) {
+    CheckWatchpoint(tlb_result.address_, 4, true, value);
+  }
+  bus_->Store32(tlb_result.address_, value);
+  if (config_.use_cached_interpreter_) {
+    // InvalidateBlock(tlb_result.address_);
+  }
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::Store64(uint64_t address, uint64_t value) {
+  if (config_.has_isolate_cache_bit_ && (cop_[0]->Read32Internal(12) & (1 << 16))) {
+    return;
+  }
+
+  MipsTlbTranslationResult tlb_result = tlb_.TranslateAddress(address);
+  if (!tlb_result.found_) {
+    cop_[0]->Write64Internal(8, address);
+    tlb_.InformTlbException(address);
+    TriggerException(ExceptionCause::kTlbMissStore);
+    return;
+  }
+  if (tlb_result.read_only_) {
+    cop_[0]->Write64Internal(8, address);
+    tlb_.InformTlbException(address);
+    TriggerException(ExceptionCause::kTlbMod);
+    return;
+  }
+
+  if (config_.use_hook_) {
+    for (auto& hook : hook_) {
+      hook->OnStore64(address, value);
+    }
+  }
+
+  if (watch_pages_ != nullptr) {
+    CheckWatchpoint(tlb_result.address_, 8, true, value);
+  }
+  bus_->Store64(tlb_result.address_, value);
+  if (config_.use_cached_interpreter_) {
+    // InvalidateBlock(address);
+  }
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::StoreMasked32(uint64_t address, uint32_t value, uint32_t mask) {
+  if (mask == 0xFFFFFFFFU) {
+    Store32(address & ~3ULL, value);
+    return;
+  }
+  StoreMaskedBytes(address, value, mask, 4);
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::StoreMasked64(uint64_t address, uint64_t value, uint64_t mask) {
+  if (mask == 0xFFFFFFFFFFFFFFFFULL) {
+    Store64(address & ~7ULL, value);
+    return;
+  }
+  StoreMaskedBytes(address, value, mask, 8);
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::StoreMaskedBytes(uint64_t address, uint64_t value, uint64_t mask, int size) {
+  if (config_.has_isolate_cache_bit_ && (cop_[0]->Read32Internal(12) & (1 << 16))) {
+    return;
+  }
+
+  // One translation covers the whole word, which never crosses a page
+  MipsTlbTranslationResult tlb_result = tlb_.TranslateAddress(address);
+  if (!tlb_result.found_) {
+    cop_[0]->Write64Internal(8, address);
+    tlb_.InformTlbException(address);
+    TriggerException(ExceptionCause::kTlbMissStore);
+    return;
+  }
+  if (tlb_result.read_only_) {
+    cop_[0]->Write64Internal(8, address);
+    tlb_.InformTlbException(address);
+    TriggerException(ExceptionCause::kTlbMod);
+    return;
+  }
+
+  uint64_t virtual_aligned = address & ~static_cast<uint64_t>(size - 1);
+  uint64_t physical_aligned = tlb_result.address_ & ~static_cast<uint64_t>(size - 1);
+  if (config_.use_hook_ || watch_pages_ != nullptr) {
+    for (int i = 0; i < size; i++) {
+      int shamt = (config_.use_big_endian_ ? size - 1 - i : i) * 8;
+      if (((mask >> shamt) & 0xFF) == 0) {
+        continue;
+      }
+      uint8_t byte = value >> shamt;
+      if (config_.use_hook_) {
+        for (auto& hook : hook_) {
+          hook->OnStore8(virtual_aligned + i, byte);
+        }
+      }
+      if (watch_pages_ != nullptr) {
+        CheckWatchpoint(physical_aligned + i, 1, true, byte);
+      }
+    }
+  }
+  bus_->StoreMasked(physical_aligned, value, mask, size, config_.use_big_endian_);
+}
+
+MIPS_TEMPLATE
+int MIPS_BASE::FetchChunk(uint64_t address, uint32_t* opcodes) {
+  MipsTlbTranslationResult tlb_result = tlb_.TranslateAddress(address);
+  if (!tlb_result.found_) {
+    // Let the scalar path raise the exception
+    return 0;
+  }
+
+  uint64_t words_to_page_end = (kFetchPageSize - (address & (kFetchPageSize - 1))) / 4;
+  int count = std::min<uint64_t>(kFetchChunkLength, words_to_page_end);
+  bus_->FetchBlock(tlb_result.address_, opcodes, count);
+  return count;
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::OnNewBlock(uint64_t address) {
+  address &= 0xFFFFFFFF;
+
+  auto& cache = cache_;
+  MipsCacheBlock<MipsBase> block;
+  block.start_ = address;
+  block.state_epoch_ = state_epoch_;
+
+  int block_length = 0;
+  uint64_t inst_address = address;
+  bool has_delay_slot = false;
+
+  for (int i = 0; i < kCacheBlockMaxLength; i++) {
+    block.entries_[i].func_ = nullptr;
+  }
+
+  // With a bus that has a fast FetchBlock, instructions are read a chunk at
+  // a time; the last chunk may run a few words past the end of the block,
+  // but never past the page. Other buses get one Fetch per instruction.
+  uint32_t fetched[kFetchChunkLength];
+  int fetched_count = 0;
+  int fetched_index = 0;
+  auto fetch_next = [&](uint64_t inst_address) {
+    if (!has_fast_fetch_block_) {
+      return Fetch(inst_address);
+    }
+    if (fetched_index == fetched_count) {
+      fetched_count = FetchChunk(inst_address, fetched);
+      fetched_index = 0;
+      if (fetched_count == 0) {
+        return Fetch(inst_address);
+      }
+    }
+    return fetched[fetched_index++];
+  };
+
+  for (int i = 0; i < kCacheBlockMaxLength - 1; i++) {
+    uint32_t opcode = fetch_next(inst_address);
+    MipsCacheEntry<MipsBase> entry;
+    entry.address_ = inst_address;
+    entry.opcode_ = opcode;
+    entry.func_ = GetInstFuncPtr(opcode);
+    block.entries_[i] = entry;
+    inst_address += 4;
+    block_length++;
+    if (IsInstBranch(opcode)) {
+      has_delay_slot = DoesInstHaveDelaySlot(opcode);
+      break;
+    }
+  }
+
+  if (has_delay_slot) {
+    uint64_t delay_slot_inst_ = fetch_next(inst_address);
+    MipsCacheEntry<MipsBase> delay_slot_entry;
+    delay_slot_entry.address_ = inst_address;
+    delay_slot_entry.opcode_ = delay_slot_inst_;
+    delay_slot_entry.func_ = GetInstFuncPtr(delay_slot_inst_);
+    block.entries_[block_length] = delay_slot_entry;
+    inst_address += 4;
+    block_length++;
+  }
+
+  block.end_ = address + block_length * 4;
+  block.length_ = block_length;
+  block.cycle_ = block_length * config_.cpi_;
+
+  if constexpr (!kHasLoadDelay) {
+    FuseUnalignedPairs(block);
+  } else {
+    ResolveLoadDelays(block);
+  }
+
+  if (!breakpoints_.empty()) {
+    for (int i = 0; i < block_length; i++) {
+      if (breakpoints_.contains(block.entries_[i].address_)) {
+        block.entries_[i].func_ = &MipsBase::InstBreakpoint;
+        // Resuming runs the delayed handler, which needs per-instruction commits
+        block.has_load_hazard_ = true;
+      }
+    }
+  }
+
+  cache.InsertBlock(block);
+  if (false) {
+    fmt::print("New block #{}: {:08X}-{:08X} ({} inst)\n", cache.GetSize(), address, inst_address, block_length);
+    for (int i = 0; i < block_length; i++) {
+      const MipsCacheEntry<MipsBase>& entry = block.entries_[i];
+      fmt::print("{:08X} | {}\n", entry.address_, MipsInst(entry.opcode_).Disassemble(entry.address_));
+    }
+  }
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::FuseUnalignedPairs(MipsCacheBlock<MipsBase>& block) {
+  // Adjacent halves of the same unaligned load run as one access. The second
+  // entry stays in the block, so retirement and cycle counts are unchanged,
+  // and only runs its half when the first one could not take both (see
+  // InstFusedLw). Stores are left alone: a fault in their second half has to
+  // leave the first half's bytes written and nothing else. RunUntil never
+  // stops between the halves of a pair.
+  for (int i = 0; i + 1 < block.length_; i++) {
+    MipsCacheEntry<MipsBase>& first = block.entries_[i];
+    MipsCacheEntry<MipsBase>& second = block.entries_[i + 1];
+    UnalignedHalf first_half = get_unaligned_half(first.opcode_);
+    UnalignedHalf second_half = get_unaligned_half(second.opcode_);
+    if (!first_half.is_valid_ || !second_half.is_valid_) {
+      continue;
+    }
+    if (first_half.pair_id_ != second_half.pair_id_ || first_half.is_left_ == second_half.is_left_) {
+      continue;
+    }
+    // Skip encodings this CPU does not execute (e.g. LDL on a 32-bit core)
+    if (first.func_ != GetInstFuncPtr(first.opcode_) || second.func_ == &MipsBase::InstUnknown) {
+      continue;
+    }
+    // Breakpoints stop between the halves, so leave those pairs alone
+    if (!breakpoints_.empty() && (breakpoints_.contains(first.address_) || breakpoints_.contains(second.address_))) {
+      continue;
+    }
+
+    ITypeInst first_inst = MipsInst(first.opcode_).GetIType();
+    ITypeInst second_inst = MipsInst(second.opcode_).GetIType();
+    if (first_inst.rs() != second_inst.rs() || first_inst.rt() != second_inst.rt()) {
+      continue;
+    }
+    // A load into its own base register changes the second half's address
+    if (first_inst.rt() == first_inst.rs()) {
+      continue;
+    }
+
+    int width = first_half.pair_id_ == MipsInstId::kLwl ? 4 : 8;
+    int32_t left_offset = sext_itype_imm_i32(first_half.is_left_ ? first_inst : second_inst);
+    int32_t right_offset = sext_itype_imm_i32(first_half.is_left_ ? second_inst : first_inst);
+    int32_t expected_delta = config_.use_big_endian_ ? width - 1 : -(width - 1);
+    if (right_offset - left_offset != expected_delta) {
+      continue;
+    }
+
+    first.func_ = width == 4 ? &MipsBase::InstFusedLw : &MipsBase::InstFusedLd;
+    second.func_ = &MipsBase::InstFusedSecondHalf;
+    i++;
+  }
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::ResolveLoadDelays(MipsCacheBlock<MipsBase>& block) {
+  // A load whose delay slot does not read its target can write it right
+  // away; nothing can observe the difference. Loads whose delay slot does
+  // read it, and a load in the last entry (its delay slot is in another
+  // block), keep the queued handler.
+  for (int i = 0; i + 1 < block.length_; i++) {
+    MipsCacheEntry<MipsBase>& entry = block.entries_[i];
+    inst_ptr_t direct = GetDirectLoadFuncPtr(entry.func_);
+    if (direct == nullptr) {
+      continue;
+    }
+    if (reads_load_target(entry.opcode_, block.entries_[i + 1].opcode_)) {
+      block.has_load_hazard_ = true;
+    } else {
+      entry.func_ = direct;
+    }
+  }
+}
+
+MIPS_TEMPLATE
+auto MIPS_BASE::GetDirectLoadFuncPtr(inst_ptr_t func) -> inst_ptr_t {
+  if (func == &MipsBase::InstLb<true>) {
+    return &MipsBase::InstLb<false>;
+  }
+  if (func == &MipsBase::InstLbu<true>) {
+    return &MipsBase::InstLbu<false>;
+  }
+  if (func == &MipsBase::InstLh<true>) {
+    return &MipsBase::InstLh<false>;
+  }
+  if (func == &MipsBase::InstLhu<true>) {
+    return &MipsBase::InstLhu<false>;
+  }
+  if (func == &MipsBase::InstLw<true>) {
+    return &MipsBase::InstLw<false>;
+  }
+  if (func == &MipsBase::InstLwc<true>) {
+    return &MipsBase::InstLwc<false>;
+  }
+  return nullptr;
+}
+
+MIPS_TEMPLATE
+bool MIPS_BASE::SaveBlockCache(const std::string& path) {
+  std::vector<MipsCacheBlockRecord> records = cache_.ExportBlocks();
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    fmt::print("Failed to open block cache file: {}\n", path);
+    return false;
+  }
+
+  BlockCacheFileHeader header;
+  header.magic_ = kBlockCacheFileMagic;
+  header.version_ = kBlockCacheFileVersion;
+  header.cpu_kind_ = (kIs64Bit ? 1 : 0) | (kHasLoadDelay ? 2 : 0) | (kHasCop0 ? 4 : 0);
+  header.count_ = records.size();
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(MipsCacheBlockRecord));
+  return file.good();
+}
+
+MIPS_TEMPLATE
+int MIPS_BASE::LoadBlockCache(const std::string& path) {
+  if (!config_.use_cached_interpreter_ || bus_ == nullptr) {
+    return 0;
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return 0;
+  }
+
+  BlockCacheFileHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+    return 0;
+  }
+  uint32_t cpu_kind = (kIs64Bit ? 1 : 0) | (kHasLoadDelay ? 2 : 0) | (kHasCop0 ? 4 : 0);
+  if (header.magic_ != kBlockCacheFileMagic || header.version_ != kBlockCacheFileVersion || header.cpu_kind_ != cpu_kind) {
+    fmt::print("Ignoring incompatible block cache file: {}\n", path);
+    return 0;
+  }
+
+  // Only rebuild blocks whose code is still the same at the same physical
+  // address. Everything else is discovered lazily as usual.
+  int rebuilt = 0;
+  for (uint32_t n = 0; n < header.count_; n++) {
+    MipsCacheBlockRecord record;
+    if (!file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+      break;
+    }
+    if (record.length_ == 0 || record.length_ > kCacheBlockMaxLength) {
+      continue;
+    }
+    if (cache_.GetBlock(record.address_) != nullptr) {
+      continue;
+    }
+
+    MipsTlbTranslationResult tlb_result = tlb_.TranslateAddress(record.address_);
+    if (!tlb_result.found_ || tlb_result.address_ != record.start_) {
+      continue;
+    }
+
+    uint32_t opcodes[kCacheBlockMaxLength];
+    for (uint32_t i = 0; i < record.length_; i++) {
+      opcodes[i] = bus_->Fetch(record.start_ + i * 4);
+    }
+    if (HashBlockCode(opcodes, record.length_) != record.hash_) {
+      continue;
+    }
 
-  bus_->Store16(tlb_result.address_, value);
-  if (config_.use_cached_interpreter_) {
-    // InvalidateBlock(address);
+    OnNewBlock(record.address_);
+    rebuilt++;
+  }
+  return rebuilt;
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::SaveState(std::vector<uint8_t>& buffer) {
+  buffer.clear();
+  MipsStateWriter writer(buffer);
+
+  StateHeader header;
+  header.magic_ = kStateMagic;
+  header.version_ = kStateVersion;
+  header.cpu_kind_ = (kIs64Bit ? 1 : 0) | (kHasLoadDelay ? 2 : 0) | (kHasCop0 ? 4 : 0);
+  header.cop_kind_ = get_state_cop_kind(config_);
+  header.section_count_ = kStateSectionCount;
+  writer.Write(header);
+
+  size_t section = writer.BeginSection();
+  writer.Write(gpr_);
+  writer.Write(hi_);
+  writer.Write(lo_);
+  writer.Write(pc_);
+  writer.Write(next_pc_);
+  writer.Write(branch_delay_dst_);
+  writer.Write(cycle_spent_total_);
+  writer.Write(inst_retired_total_);
+  writer.Write<int32_t>(cpi_counter_);
+  writer.Write<int32_t>(interrupt_poll_counter_);
+  writer.Write<int32_t>(cop_cause_);
+  writer.Write<int32_t>(delayed_load_op_.delay_counter_);
+  writer.Write<int32_t>(delayed_load_op_.cop_id_);
+  writer.Write<int32_t>(delayed_load_op_.dst_);
+  writer.Write(delayed_load_op_.value_);
+  writer.Write<uint8_t>(delayed_load_op_.is_active_);
+  writer.Write<uint8_t>(llbit_);
+  writer.Write<uint8_t>(has_branch_delay_);
+  writer.Write<uint8_t>(compare_interrupt_);
+  writer.Write<uint8_t>(halt_);
+  writer.EndSection(section);
+
+  for (int i = 0; i < 4; i++) {
+    section = writer.BeginSection();
+    cop_[i]->SaveState(writer);
+    writer.EndSection(section);
   }
+
+  section = writer.BeginSection();
+  tlb_.SaveState(writer);
+  writer.EndSection(section);
 }
 
 MIPS_TEMPLATE
-void MIPS_BASE::Store32(uint64_t address, uint32_t value) {
-  if (config_.has_isolate_cache_bit_ && (cop_[0]->Read32Internal(12) & (1 << 16))) {
-    return;
+bool MIPS_BASE::LoadState(const std::vector<uint8_t>& buffer) {
+  MipsStateReader reader(buffer.data(), buffer.size());
+
+  StateHeader header;
+  if (!reader.Read(header)) {
+    return false;
+  }
+  uint32_t cpu_kind = (kIs64Bit ? 1 : 0) | (kHasLoadDelay ? 2 : 0) | (kHasCop0 ? 4 : 0);
+  if (header.magic_ != kStateMagic || header.version_ != kStateVersion || header.cpu_kind_ != cpu_kind ||
+      header.cop_kind_ != get_state_cop_kind(config_) || header.section_count_ != kStateSectionCount ||
+      !is_state_layout_valid(reader, kStateSectionCount)) {
+    fmt::print("Ignoring incompatible CPU state\n");
+    return false;
   }
 
-  MipsTlbTranslationResult tlb_result = tlb_.TranslateAddress(address);
-  if (!tlb_result.found_) {
-    cop_[0]->Write64Internal(8, address);
-    tlb_.InformTlbException(address);
-    TriggerException(ExceptionCause::kTlbMissStore);
-    return;
+  // Every section is decoded before anything is written, so a bad buffer
+  // leaves the CPU as it was
+  MipsStateReader core = reader.ReadSection();
+  uint64_t gpr[32];
+  uint64_t hi = 0;
+  uint64_t lo = 0;
+  uint64_t pc = 0;
+  uint64_t next_pc = 0;
+  uint64_t branch_delay_dst = 0;
+  uint64_t cycle_spent_total = 0;
+  uint64_t inst_retired_total = 0;
+  int32_t cpi_counter = 0;
+  int32_t interrupt_poll_counter = 0;
+  int32_t cop_cause = 0;
+  int32_t delay_counter = 0;
+  int32_t cop_id = 0;
+  int32_t dst = 0;
+  uint32_t value = 0;
+  uint8_t is_active = 0;
+  uint8_t llbit = 0;
+  uint8_t has_branch_delay = 0;
+  uint8_t compare_interrupt = 0;
+  uint8_t halt = 0;
+  core.Read(gpr);
+  core.Read(hi);
+  core.Read(lo);
+  core.Read(pc);
+  core.Read(next_pc);
+  core.Read(branch_delay_dst);
+  core.Read(cycle_spent_total);
+  core.Read(inst_retired_total);
+  core.Read(cpi_counter);
+  core.Read(interrupt_poll_counter);
+  core.Read(cop_cause);
+  core.Read(delay_counter);
+  core.Read(cop_id);
+  core.Read(dst);
+  core.Read(value);
+  core.Read(is_active);
+  core.Read(llbit);
+  core.Read(has_branch_delay);
+  core.Read(compare_interrupt);
+  core.Read(halt);
+  // A pending load's target indexes the GPRs or a coprocessor
+  if (!core.IsFinished() || cop_id < -1 || cop_id >= 4 || dst < 0 || dst >= 32) {
+    return false;
+  }
+
+  // Coprocessor and TLB sections are decoded once to check them and again
+  // to commit them
+  MipsStateReader components = reader;
+  for (int i = 0; i < 4; i++) {
+    MipsStateReader cop = reader.ReadSection();
+    if (!cop_[i]->LoadState(cop, false) || !cop.IsFinished()) {
+      return false;
+    }
   }
-  if (tlb_result.read_only_) {
-    cop_[0]->Write64Internal(8, address);
-    tlb_.InformTlbException(address);
-    TriggerException(ExceptionCause::kTlbMod);
-    return;
+  MipsStateReader tlb = reader.ReadSection();
+  if (!tlb_.LoadState(tlb, false) || !tlb.IsFinished()) {
+    return false;
   }
 
-  if (kLogNullWrites || kPanicOnNullWrites) {
-    if (address == 0 || address == 0x80000000 || address == 0xA0000000) {
-      bool is_pc_known = false;
-      for (auto known_pc : kPsxKnownNullWritePc) {
-        is_pc_known |= pc_ == known_pc;
-      }
-      if (!is_pc_known) {
-        fmt::print("PC:{:08X} | [NULL] <- {:08X}\n", pc_, value);
-        if (kPanicOnNullWrites) {
-          DumpProcessorLog();
-          PANIC("Null write");
-        }
+  std::memcpy(gpr_, gpr, sizeof(gpr_));
+  hi_ = hi;
+  lo_ = lo;
+  pc_ = pc;
+  next_pc_ = next_pc;
+  branch_delay_dst_ = branch_delay_dst;
+  cycle_spent_total_ = cycle_spent_total;
+  inst_retired_total_ = inst_retired_total;
+  cpi_counter_ = cpi_counter;
+  interrupt_poll_counter_ = interrupt_poll_counter;
+  cop_cause_ = cop_cause;
+  delayed_load_op_.delay_counter_ = delay_counter;
+  delayed_load_op_.cop_id_ = cop_id;
+  delayed_load_op_.dst_ = dst;
+  delayed_load_op_.value_ = value;
+  delayed_load_op_.is_active_ = is_active != 0;
+  llbit_ = llbit != 0;
+  has_branch_delay_ = has_branch_delay != 0;
+  compare_interrupt_ = compare_interrupt != 0;
+  halt_ = halt != 0;
+  for (int i = 0; i < 4; i++) {
+    MipsStateReader cop = components.ReadSection();
+    cop_[i]->LoadState(cop, true);
+  }
+  tlb = components.ReadSection();
+  tlb_.LoadState(tlb, true);
+
+  // Memory is restored by the owner of the bus, so cached blocks are
+  // checked against it the next time each one is entered
+  state_epoch_++;
+  return true;
+}
+
+MIPS_TEMPLATE
+MipsCacheBlock<MIPS_BASE>* MIPS_BASE::RevalidateBlock(MipsCacheBlock<MipsBase>* block) {
+  uint32_t opcodes[kCacheBlockMaxLength];
+  bus_->FetchBlock(block->start_, opcodes, block->length_);
+  for (int i = 0; i < block->length_; i++) {
+    if (opcodes[i] != block->entries_[i].opcode_) {
+      cache_.InvalidatePhysicalBlock(block->start_);
+      if (cache_.HasPendingWork()) {
+        cache_.ExecuteCacheClear();
       }
+      return nullptr;
     }
   }
+  block->state_epoch_ = state_epoch_;
+  return block;
+}
 
-  if (config_.use_hook_) {
-    for (auto& hook : hook_) {
-      hook->OnStore32(address, value);
-    }
+MIPS_TEMPLATE
+void MIPS_BASE::AddBreakpoint(uint64_t pc) {
+  pc &= 0xFFFFFFFF;
+  breakpoints_.insert(pc);
+  RebuildBlocksAt(pc);
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::RemoveBreakpoint(uint64_t pc) {
+  pc &= 0xFFFFFFFF;
+  if (breakpoints_.erase(pc) != 0) {
+    RebuildBlocksAt(pc);
   }
+}
 
-  bus_->Store32(tlb_result.address_, value);
-  if (config_.use_cached_interpreter_) {
-    // InvalidateBlock(tlb_result.address_);
+MIPS_TEMPLATE
+void MIPS_BASE::ClearBreakpoints() {
+  for (uint64_t pc : breakpoints_) {
+    RebuildBlocksAt(pc);
   }
+  breakpoints_.clear();
 }
 
 MIPS_TEMPLATE
-void MIPS_BASE::Store64(uint64_t address, uint64_t value) {
-  if (config_.has_isolate_cache_bit_ && (cop_[0]->Read32Internal(12) & (1 << 16))) {
+void MIPS_BASE::RebuildBlocksAt(uint64_t pc) {
+  if (!config_.use_cached_interpreter_) {
     return;
   }
+  // Every block covering the PC is rebuilt with or without the check
+  cache_.InvalidateBlockRange(pc, pc + 4);
+}
 
-  MipsTlbTranslationResult tlb_result = tlb_.TranslateAddress(address);
-  if (!tlb_result.found_) {
-    cop_[0]->Write64Internal(8, address);
-    tlb_.InformTlbException(address);
-    TriggerException(ExceptionCause::kTlbMissStore);
+MIPS_TEMPLATE
+void MIPS_BASE::AddWatchpoint(uint64_t address, uint32_t length, bool on_read, bool on_write) {
+  if (length == 0) {
     return;
   }
-  if (tlb_result.read_only_) {
-    cop_[0]->Write64Internal(8, address);
-    tlb_.InformTlbException(address);
-    TriggerException(ExceptionCause::kTlbMod);
-    return;
+  if (watch_pages_ == nullptr) {
+    watch_pages_ = std::make_unique<uint64_t[]>(kWatchPageWords);
   }
-
-  if (config_.use_hook_) {
-    for (auto& hook : hook_) {
-      hook->OnStore64(address, value);
-    }
+  address &= 0xFFFFFFFF;
+  watchpoints_.push_back(MipsWatchpoint{address, length, on_read, on_write});
+  uint64_t last = std::min<uint64_t>(address + length - 1, 0xFFFFFFFF);
+  for (uint64_t page = address >> kWatchPageShift; page <= (last >> kWatchPageShift); page++) {
+    watch_pages_[page >> 6] |= 1ULL << (page & 63);
   }
+}
 
-  bus_->Store64(tlb_result.address_, value);
-  if (config_.use_cached_interpreter_) {
-    // InvalidateBlock(address);
-  }
+MIPS_TEMPLATE
+void MIPS_BASE::ClearWatchpoints() {
+  watchpoints_.clear();
+  watch_pages_.reset();
 }
 
 MIPS_TEMPLATE
-void MIPS_BASE::OnNewBlock(uint64_t address) {
+void MIPS_BASE::CheckWatchpoint(uint64_t address, int size, bool is_store, uint64_t value) {
   address &= 0xFFFFFFFF;
-
-  auto& cache = cache_;
-  MipsCacheBlock<MipsBase> block;
-  block.start_ = address;
-
-  int block_length = 0;
-  uint64_t inst_address = address;
-  bool has_delay_slot = false;
-
-  for (int i = 0; i < kCacheBlockMaxLength; i++) {
-    block.entries_[i].func_ = nullptr;
+  uint64_t page = address >> kWatchPageShift;
+  if ((watch_pages_[page >> 6] & (1ULL << (page & 63))) == 0) {
+    return;
+  }
+  if (debug_stop_.kind_ != MipsDebugStopKind::kNone) {
+    return;
   }
 
-  for (int i = 0; i < kCacheBlockMaxLength - 1; i++) {
-    uint32_t opcode = Fetch(inst_address);
-    MipsCacheEntry<MipsBase> entry;
-    entry.address_ = inst_address;
-    entry.opcode_ = opcode;
-    entry.func_ = GetInstFuncPtr(opcode);
-    block.entries_[i] = entry;
-    inst_address += 4;
-    block_length++;
-    if (IsInstBranch(opcode)) {
-      has_delay_slot = DoesInstHaveDelaySlot(opcode);
-      break;
+  for (const MipsWatchpoint& watchpoint : watchpoints_) {
+    bool kind_match = is_store ? watchpoint.on_write_ : watchpoint.on_read_;
+    bool overlaps = address < watchpoint.address_ + watchpoint.length_ && watchpoint.address_ < address + size;
+    if (kind_match && overlaps) {
+      debug_stop_.kind_ = MipsDebugStopKind::kWatchpoint;
+      debug_stop_.pc_ = pc_;
+      debug_stop_.address_ = address;
+      debug_stop_.value_ = value;
+      debug_stop_.size_ = size;
+      debug_stop_.is_store_ = is_store;
+      return;
     }
   }
+}
 
-  if (has_delay_slot) {
-    uint64_t delay_slot_inst_ = Fetch(inst_address);
-    MipsCacheEntry<MipsBase> delay_slot_entry;
-    delay_slot_entry.address_ = inst_address;
-    delay_slot_entry.opcode_ = delay_slot_inst_;
-    delay_slot_entry.func_ = GetInstFuncPtr(delay_slot_inst_);
-    block.entries_[block_length] = delay_slot_entry;
-    inst_address += 4;
-    block_length++;
+MIPS_TEMPLATE
+MipsStopReason MIPS_BASE::GetDebugStopReason() {
+  if (debug_stop_.kind_ == MipsDebugStopKind::kBreakpoint) {
+    return MipsStopReason::kBreakpoint;
   }
+  return MipsStopReason::kWatchpoint;
+}
 
-  block.end_ = address + block_length * 4;
-  block.length_ = block_length;
-  block.cycle_ = block_length * config_.cpi_;
-
-  cache.InsertBlock(block);
-  if (false) {
-    fmt::print("New block #{}: {:08X}-{:08X} ({} inst)\n", cache.GetSize(), address, inst_address, block_length);
-    for (int i = 0; i < block_length; i++) {
-      const MipsCacheEntry<MipsBase>& entry = block.entries_[i];
-      fmt::print("{:08X} | {}\n", entry.address_, MipsInst(entry.opcode_).Disassemble(entry.address_));
-    }
+MIPS_TEMPLATE
+void MIPS_BASE::InvalidateCode(uint64_t address, uint32_t length) {
+  if (!config_.use_cached_interpreter_) {
+    return;
   }
+  cache_.InvalidatePhysicalRange(address, address + length);
 }
 
 MIPS_TEMPLATE
@@ -1939,6 +3319,7 @@ void MIPS_BASE::InstBreak(uint32_t opcode) {
 }
 
 MIPS_TEMPLATE
+template <bool kIsDelayed>
 void MIPS_BASE::InstLb(uint32_t opcode) {
   ITypeInst inst = MipsInst(opcode).GetIType();
   uint64_t rs_value = ReadGpr64(inst.rs());
@@ -1947,11 +3328,12 @@ void MIPS_BASE::InstLb(uint32_t opcode) {
   LoadResult8 load_result = Load8(address);
   if (load_result.has_value) {
     int64_t rt_value = sext_i8_to_i64(load_result.value);
-    QueueDelayedLoad(inst.rt(), rt_value);
+    CompleteLoad<kIsDelayed>(inst.rt(), rt_value);
   }
 }
 
 MIPS_TEMPLATE
+template <bool kIsDelayed>
 void MIPS_BASE::InstLbu(uint32_t opcode) {
   ITypeInst inst = MipsInst(opcode).GetIType();
   uint64_t rs_value = ReadGpr64(inst.rs());
@@ -1960,11 +3342,12 @@ void MIPS_BASE::InstLbu(uint32_t opcode) {
   LoadResult8 load_result = Load8(address);
   if (load_result.has_value) {
     uint8_t rt_value = load_result.value;
-    QueueDelayedLoad(inst.rt(), rt_value);
+    CompleteLoad<kIsDelayed>(inst.rt(), rt_value);
   }
 }
 
 MIPS_TEMPLATE
+template <bool kIsDelayed>
 void MIPS_BASE::InstLh(uint32_t opcode) {
   ITypeInst inst = MipsInst(opcode).GetIType();
   uint64_t rs_value = ReadGpr64(inst.rs());
@@ -1978,11 +3361,12 @@ void MIPS_BASE::InstLh(uint32_t opcode) {
   LoadResult16 load_result = Load16(address);
   if (load_result.has_value) {
     int64_t rt_value = sext_i16_to_i64(load_result.value);
-    QueueDelayedLoad(inst.rt(), rt_value);
+    CompleteLoad<kIsDelayed>(inst.rt(), rt_value);
   }
 }
 
 MIPS_TEMPLATE
+template <bool kIsDelayed>
 void MIPS_BASE::InstLhu(uint32_t opcode) {
   ITypeInst inst = MipsInst(opcode).GetIType();
   uint64_t rs_value = ReadGpr64(inst.rs());
@@ -1996,11 +3380,12 @@ void MIPS_BASE::InstLhu(uint32_t opcode) {
   LoadResult16 load_result = Load16(address);
   if (load_result.has_value) {
     uint16_t rt_value = load_result.value;
-    QueueDelayedLoad(inst.rt(), rt_value);
+    CompleteLoad<kIsDelayed>(inst.rt(), rt_value);
   }
 }
 
 MIPS_TEMPLATE
+template <bool kIsDelayed>
 void MIPS_BASE::InstLw(uint32_t opcode) {
   ITypeInst inst = MipsInst(opcode).GetIType();
   uint64_t rs_value = ReadGpr64(inst.rs());
@@ -2014,7 +3399,7 @@ void MIPS_BASE::InstLw(uint32_t opcode) {
   LoadResult32 load_result = Load32(address);
   if (load_result.has_value) {
     int64_t rt_value = sext_i32_to_i64(load_result.value);
-    QueueDelayedLoad(inst.rt(), rt_value);
+    CompleteLoad<kIsDelayed>(inst.rt(), rt_value);
   }
 }
 
@@ -2030,20 +3415,14 @@ void MIPS_BASE::InstLwl(uint32_t opcode) {
   int32_t imm = sext_itype_imm_i32(inst);
   uint64_t address = rs_value + imm;
   uint32_t rt_value = ReadGpr32(inst.rt());
-  int address_unalignment = address & 3;
+  int shamt = unaligned_shamt32(address, config_.use_big_endian_);
 
-  if (config_.use_big_endian_) {
-    address_unalignment = 3 - address_unalignment;
-  }
-  for (int i = 0; i < address_unalignment + 1; i++) {
-    uint64_t addr = address + i;
-    LoadResult8 load_result = Load8(addr);
-    if (load_result.has_value) {
-      int shamt = (3 - i) * 8;
-      rt_value &= ~(0xFF << shamt);
-      rt_value |= load_result.value << shamt;
-    }
+  LoadResult32 load_result = LoadAligned32(address);
+  if (!load_result.has_value) {
+    return;
   }
+  uint32_t keep_mask = ~(0xFFFFFFFFU << shamt);
+  rt_value = (rt_value & keep_mask) | (load_result.value << shamt);
 
   WriteGpr32Sext(inst.rt(), rt_value);
 }
@@ -2060,26 +3439,20 @@ void MIPS_BASE::InstLwr(uint32_t opcode) {
   int32_t imm = sext_itype_imm_i32(inst);
   uint64_t address = rs_value + imm;
   uint32_t rt_value = ReadGpr32(inst.rt());
-  int address_unalignment = address & 3;
+  int shamt = 24 - unaligned_shamt32(address, config_.use_big_endian_);
 
-  address_unalignment = 3 - address_unalignment;
-  if (config_.use_big_endian_) {
-    address_unalignment = 3 - address_unalignment;
-  }
-  for (int i = 0; i < address_unalignment + 1; i++) {
-    uint64_t addr = address - i;
-    LoadResult8 load_result = Load8(addr);
-    if (load_result.has_value) {
-      int shamt = i * 8;
-      rt_value &= ~(0xFF << shamt);
-      rt_value |= load_result.value << shamt;
-    }
+  LoadResult32 load_result = LoadAligned32(address);
+  if (!load_result.has_value) {
+    return;
   }
+  uint32_t keep_mask = ~(0xFFFFFFFFU >> shamt);
+  rt_value = (rt_value & keep_mask) | (load_result.value >> shamt);
 
   WriteGpr32Sext(inst.rt(), rt_value);
 }
 
 MIPS_TEMPLATE
+template <bool kIsDelayed>
 void MIPS_BASE::InstLwc(uint32_t opcode) {
   uint8_t cop_id = (opcode >> 26) & 3;
   if (config_.cop_decoding_override_ & (1 << cop_id)) {
@@ -2100,7 +3473,7 @@ void MIPS_BASE::InstLwc(uint32_t opcode) {
   LoadResult32 load_result = Load32(address);
   if (load_result.has_value) {
     uint32_t copt_value = load_result.value;
-    QueueDelayedCopLoad(cop_id, inst.rt(), copt_value);
+    CompleteCopLoad<kIsDelayed>(cop_id, inst.rt(), copt_value);
   }
 }
 
@@ -2151,16 +3524,9 @@ void MIPS_BASE::InstSwl(uint32_t opcode) {
   int32_t imm = sext_itype_imm_i32(inst);
   uint64_t address = rs_value + imm;
   uint32_t rt_value = ReadGpr32(inst.rt());
-  int address_unalignment = address & 3;
+  int shamt = unaligned_shamt32(address, config_.use_big_endian_);
 
-  if (config_.use_big_endian_) {
-    address_unalignment = 3 - address_unalignment;
-  }
-  for (int i = 0; i < address_unalignment + 1; i++) {
-    uint64_t addr = address + i;
-    int shamt = (3 - i) * 8;
-    Store8(addr, rt_value >> shamt);
-  }
+  StoreMasked32(address, rt_value >> shamt, 0xFFFFFFFFU >> shamt);
 }
 
 MIPS_TEMPLATE
@@ -2170,17 +3536,9 @@ void MIPS_BASE::InstSwr(uint32_t opcode) {
   int32_t imm = sext_itype_imm_i32(inst);
   uint64_t address = rs_value + imm;
   uint32_t rt_value = ReadGpr32(inst.rt());
-  int address_unalignment = address & 3;
+  int shamt = 24 - unaligned_shamt32(address, config_.use_big_endian_);
 
-  address_unalignment = 3 - address_unalignment;
-  if (config_.use_big_endian_) {
-    address_unalignment = 3 - address_unalignment;
-  }
-  for (int i = 0; i < address_unalignment + 1; i++) {
-    uint64_t addr = address - i;
-    int shamt = i * 8;
-    Store8(addr, rt_value >> shamt);
-  }
+  StoreMasked32(address, rt_value << shamt, 0xFFFFFFFFU << shamt);
 }
 
 MIPS_TEMPLATE
@@ -2337,6 +3695,73 @@ void MIPS_BASE::InstCtc(uint32_t opcode) {
   cop_[cop_id]->Write32(inst.rd() + 32, rt_value);
 }
 
+MIPS_TEMPLATE
+template <void (MipsRspVu::*kOp)(uint32_t)>
+void MIPS_BASE::InstVuCompute(uint32_t opcode) {
+  if (!IsCopEnabled(2)) {
+    cop_cause_ = 2;
+    TriggerException(ExceptionCause::kCop);
+    return;
+  }
+  (rsp_vu_->*kOp)(opcode);
+}
+
+MIPS_TEMPLATE
+template <void (MipsRspVu::*kOp)(uint32_t, uint32_t)>
+void MIPS_BASE::InstVuMemory(uint32_t opcode) {
+  if (!IsCopEnabled(2)) {
+    cop_cause_ = 2;
+    TriggerException(ExceptionCause::kCop);
+    return;
+  }
+  ITypeInst inst = MipsInst(opcode).GetIType();
+  (rsp_vu_->*kOp)(opcode, ReadGpr32(inst.rs()));
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::InstVuMfc(uint32_t opcode) {
+  if (!IsCopEnabled(2)) {
+    cop_cause_ = 2;
+    TriggerException(ExceptionCause::kCop);
+    return;
+  }
+  RTypeInst inst = MipsInst(opcode).GetRType();
+  WriteGpr32Sext(inst.rt(), rsp_vu_->ReadElement(inst.rd(), (opcode >> 7) & 0xF));
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::InstVuCfc(uint32_t opcode) {
+  if (!IsCopEnabled(2)) {
+    cop_cause_ = 2;
+    TriggerException(ExceptionCause::kCop);
+    return;
+  }
+  RTypeInst inst = MipsInst(opcode).GetRType();
+  WriteGpr32Sext(inst.rt(), rsp_vu_->ReadControl(inst.rd()));
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::InstVuMtc(uint32_t opcode) {
+  if (!IsCopEnabled(2)) {
+    cop_cause_ = 2;
+    TriggerException(ExceptionCause::kCop);
+    return;
+  }
+  RTypeInst inst = MipsInst(opcode).GetRType();
+  rsp_vu_->WriteElement(inst.rd(), (opcode >> 7) & 0xF, ReadGpr32(inst.rt()));
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::InstVuCtc(uint32_t opcode) {
+  if (!IsCopEnabled(2)) {
+    cop_cause_ = 2;
+    TriggerException(ExceptionCause::kCop);
+    return;
+  }
+  RTypeInst inst = MipsInst(opcode).GetRType();
+  rsp_vu_->WriteControl(inst.rd(), ReadGpr32(inst.rt()));
+}
+
 MIPS_TEMPLATE
 void MIPS_BASE::InstNop(uint32_t opcode) {
 }
@@ -2805,21 +4230,14 @@ void MIPS_BASE::InstLdl(uint32_t opcode) {
   int32_t imm = sext_itype_imm_i32(inst);
   uint64_t address = rs_value + imm;
   uint64_t rt_value = ReadGpr64(inst.rt());
-  int address_unalignment = address & 7;
-  uint64_t address_aligned = address & ~7ULL;
+  int shamt = unaligned_shamt64(address, config_.use_big_endian_);
 
-  if (config_.use_big_endian_) {
-    address_unalignment = 7 - address_unalignment;
-  }
-  for (int i = 0; i < address_unalignment + 1; i++) {
-    uint64_t addr = address + i;
-    LoadResult8 load_result = Load8(addr);
-    if (load_result.has_value) {
-      int shamt = (7 - i) * 8;
-      rt_value &= ~(0xFFULL << shamt);
-      rt_value |= (uint64_t)load_result.value << shamt;
-    }
+  LoadResult64 load_result = LoadAligned64(address);
+  if (!load_result.has_value) {
+    return;
   }
+  uint64_t keep_mask = ~(0xFFFFFFFFFFFFFFFFULL << shamt);
+  rt_value = (rt_value & keep_mask) | (load_result.value << shamt);
 
   WriteGpr64(inst.rt(), rt_value);
 }
@@ -2831,22 +4249,14 @@ void MIPS_BASE::InstLdr(uint32_t opcode) {
   int32_t imm = sext_itype_imm_i32(inst);
   uint64_t address = rs_value + imm;
   uint64_t rt_value = ReadGpr64(inst.rt());
-  int address_unalignment = address & 7;
-  uint64_t address_aligned = address & ~7ULL;
+  int shamt = 56 - unaligned_shamt64(address, config_.use_big_endian_);
 
-  address_unalignment = 7 - address_unalignment;
-  if (config_.use_big_endian_) {
-    address_unalignment = 7 - address_unalignment;
-  }
-  for (int i = 0; i < address_unalignment + 1; i++) {
-    uint64_t addr = address - i;
-    LoadResult8 load_result = Load8(addr);
-    if (load_result.has_value) {
-      int shamt = i * 8;
-      rt_value &= ~(0xFFULL << shamt);
-      rt_value |= (uint64_t)load_result.value << shamt;
-    }
+  LoadResult64 load_result = LoadAligned64(address);
+  if (!load_result.has_value) {
+    return;
   }
+  uint64_t keep_mask = ~(0xFFFFFFFFFFFFFFFFULL >> shamt);
+  rt_value = (rt_value & keep_mask) | (load_result.value >> shamt);
 
   WriteGpr64(inst.rt(), rt_value);
 }
@@ -2907,16 +4317,9 @@ void MIPS_BASE::InstSdl(uint32_t opcode) {
   int32_t imm = sext_itype_imm_i32(inst);
   uint64_t address = rs_value + imm;
   uint64_t rt_value = ReadGpr64(inst.rt());
-  int address_unalignment = address & 7;
+  int shamt = unaligned_shamt64(address, config_.use_big_endian_);
 
-  if (config_.use_big_endian_) {
-    address_unalignment = 7 - address_unalignment;
-  }
-  for (int i = 0; i < address_unalignment + 1; i++) {
-    uint64_t addr = address + i;
-    int shamt = (7 - i) * 8;
-    Store8(addr, rt_value >> shamt);
-  }
+  StoreMasked64(address, rt_value >> shamt, 0xFFFFFFFFFFFFFFFFULL >> shamt);
 }
 
 MIPS_TEMPLATE
@@ -2926,16 +4329,118 @@ void MIPS_BASE::InstSdr(uint32_t opcode) {
   int32_t imm = sext_itype_imm_i32(inst);
   uint64_t address = rs_value + imm;
   uint64_t rt_value = ReadGpr64(inst.rt());
-  int address_unalignment = address & 7;
+  int shamt = 56 - unaligned_shamt64(address, config_.use_big_endian_);
+
+  StoreMasked64(address, rt_value << shamt, 0xFFFFFFFFFFFFFFFFULL << shamt);
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::InstFusedLw(uint32_t opcode) {
+  ITypeInst inst = MipsInst(opcode).GetIType();
+  bool is_left = inst.op() == kOpLwl;
+  uint64_t rs_value = ReadGpr64(inst.rs());
+  uint64_t first_address = rs_value + sext_itype_imm_i32(inst);
+  uint64_t address = get_fused_pair_address(rs_value, inst, is_left, config_.use_big_endian_, 4);
+
+  // Run this half alone when it sits in a delay slot (the second half is not
+  // next) or when the second half's word may be on another page, where it
+  // has to fault with its own PC. InstFusedSecondHalf makes the same check.
+  if (next_pc_ != pc_ + 4 || !is_fused_pair_in_page(address, 4)) {
+    if (is_left) {
+      InstLwl(opcode);
+    } else {
+      InstLwr(opcode);
+    }
+    return;
+  }
+
+  LoadResult32 first = LoadAligned32(first_address);
+  if (!first.has_value) {
+    return;
+  }
+  // The second half reads its word even when it is the same one, so the bus
+  // sees the same accesses as from the separate halves
+  bool is_first_low = first_address == address;
+  LoadResult32 second = LoadAligned32(is_first_low ? address + 3 : address);
+  uint32_t value = first.value;
+  int shamt = (address & 3) * 8;
+  if (shamt != 0) {
+    uint32_t low = is_first_low ? first.value : second.value;
+    uint32_t high = is_first_low ? second.value : first.value;
+    if (config_.use_big_endian_) {
+      value = (low << shamt) | (high >> (32 - shamt));
+    } else {
+      value = (low >> shamt) | (high << (32 - shamt));
+    }
+  }
+
+  WriteGpr32Sext(inst.rt(), value);
+}
+
+MIPS_TEMPLATE
+void MIPS_BASE::InstFusedLd(uint32_t opcode) {
+  ITypeInst inst = MipsInst(opcode).GetIType();
+  bool is_left = inst.op() == kOpLdl;
+  uint64_t rs_value = ReadGpr64(inst.rs());
+  uint64_t first_address = rs_value + sext_itype_imm_i32(inst);
+  uint64_t address = get_fused_pair_address(rs_value, inst, is_left, config_.use_big_endian_, 8);
+
+  if (next_pc_ != pc_ + 4 || !is_fused_pair_in_page(address, 8)) {
+    if (is_left) {
+      InstLdl(opcode);
+    } else {
+      InstLdr(opcode);
+    }
+    return;
+  }
+
+  LoadResult64 first = LoadAligned64(first_address);
+  if (!first.has_value) {
+    return;
+  }
+  bool is_first_low = first_address == address;
+  LoadResult64 second = LoadAligned64(is_first_low ? address + 7 : address);
+  uint64_t value = first.value;
+  int shamt = (address & 7) * 8;
+  if (shamt != 0) {
+    uint64_t low = is_first_low ? first.value : second.value;
+    uint64_t high = is_first_low ? second.value : first.value;
+    if (config_.use_big_endian_) {
+      value = (low << shamt) | (high >> (64 - shamt));
+    } else {
+      value = (low >> shamt) | (high << (64 - shamt));
+    }
+  }
+
+  WriteGpr64(inst.rt(), value);
+}
 
-  address_unalignment = 7 - address_unalignment;
-  if (config_.use_big_endian_) {
-    address_unalignment = 7 - address_unalignment;
+MIPS_TEMPLATE
+void MIPS_BASE::InstFusedSecondHalf(uint32_t opcode) {
+  // The base register is unchanged since the first half, so this finds the
+  // same pair address it did. A first half in a delay slot never gets here.
+  ITypeInst inst = MipsInst(opcode).GetIType();
+  bool is_word = inst.op() == kOpLwl || inst.op() == kOpLwr;
+  bool is_left = inst.op() == kOpLwl || inst.op() == kOpLdl;
+  int width = is_word ? 4 : 8;
+  uint64_t address = get_fused_pair_address(ReadGpr64(inst.rs()), inst, is_left, config_.use_big_endian_, width);
+  if (is_fused_pair_in_page(address, width)) {
+    return;
   }
-  for (int i = 0; i < address_unalignment + 1; i++) {
-    uint64_t addr = address - i;
-    int shamt = i * 8;
-    Store8(addr, rt_value >> shamt);
+
+  switch (inst.op()) {
+    case kOpLwl:
+      InstLwl(opcode);
+      break;
+    case kOpLwr:
+      InstLwr(opcode);
+      break;
+    case kOpLdl:
+      InstLdl(opcode);
+      break;
+    default:
+      InstLdr(opcode);
+      break;
   }
 }
 
@@ -2944,6 +4449,32 @@ void MIPS_BASE::InstSync(uint32_t opcode) {
   // Do nothing
 }
 
+MIPS_TEMPLATE
+void MIPS_BASE::InstBreakpoint(uint32_t opcode) {
+  // Stands in for the instruction at a breakpoint PC in cached blocks
+  if (pc_ == breakpoint_resume_pc_) {
+    breakpoint_resume_pc_ = kNoBreakpointResume;
+    inst_ptr_t fp = GetInstFuncPtr(opcode);
+    (this->*fp)(opcode);
+    return;
+  }
+
+  // Undo what ExecuteBlock did for this instruction so that resuming runs it
+  // as if the stop never happened. A delay slot whose branch target is pc+4
+  // behaves the same either way.
+  if (next_pc_ != pc_ + 4) {
+    has_branch_delay_ = true;
+    branch_delay_dst_ = next_pc_;
+  }
+  next_pc_ = pc_;
+  inst_retired_total_--;
+  cpi_counter_ -= config_.cpi_;
+
+  debug_stop_.kind_ = MipsDebugStopKind::kBreakpoint;
+  debug_stop_.pc_ = pc_;
+  breakpoint_resume_pc_ = pc_;
+}
+
 MIPS_TEMPLATE
 void MIPS_BASE::InstUnknown(uint32_t opcode) {
   fmt::print("Unknown instruction: {:08X} @ {:08X}\n", opcode, pc_);
@@ -2970,3 +4501,11 @@ std::string MipsLog::ToString(bool is_64bit) {
 // Explicit instantiations — keep definitions out of other TUs
 template class MipsBase<MipsTlbNormal, true, false, true>;
 template class MipsBase<MipsTlbDummy, false, false, false>;
+template class MipsBase<MipsTlbDummy, false, true, true>;
+
+#ifdef NGMIPS_BUS_INSTANTIATIONS
+#define NGMIPS_INSTANTIATE(TlbType, kIs64Bit, kHasLoadDelay, kHasCop0, BusType) \
+  template class MipsBase<TlbType, kIs64Bit, kHasLoadDelay, kHasCop0, BusType>;
+#include NGMIPS_BUS_INSTANTIATIONS
+#undef NGMIPS_INSTANTIATE
+#endif
@@ -0,0 +1,117 @@
+#include "mips_batch_runner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+void MipsBatchCpuJob::RunSlice(int cycle) {
+  for (auto& cpu : cpus_) {
+    cpu->Run(cycle);
+  }
+}
+
+uint64_t MipsBatchCpuJob::GetInstRetired() {
+  uint64_t inst_retired = 0;
+  for (auto& cpu : cpus_) {
+    inst_retired += cpu->GetInstRetired();
+  }
+  return inst_retired;
+}
+
+MipsBatchRunner::MipsBatchRunner(int thread_count) {
+  if (thread_count <= 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  thread_count_ = thread_count;
+  for (int i = 0; i < thread_count_; i++) {
+    queues_.push_back(std::make_unique<WorkerQueue>());
+  }
+  inst_retired_ = 0;
+  slices_ = 0;
+  steals_ = 0;
+}
+
+void MipsBatchRunner::AddJob(MipsBatchFactory factory, uint64_t cycle_budget) {
+  auto job = std::make_unique<Job>();
+  job->factory_ = std::move(factory);
+  job->cycle_budget_ = cycle_budget;
+  jobs_.push_back(std::move(job));
+}
+
+MipsBatchStats MipsBatchRunner::Run(int slice_cycles) {
+  MipsBatchStats stats;
+  stats.jobs_ = jobs_.size();
+
+  for (size_t i = 0; i < jobs_.size(); i++) {
+    queues_[i % thread_count_]->jobs_.push_back(jobs_[i].get());
+  }
+  inst_retired_ = 0;
+  slices_ = 0;
+  steals_ = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_count_; i++) {
+    threads.emplace_back(&MipsBatchRunner::WorkerMain, this, i, slice_cycles);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  jobs_.clear();
+  stats.inst_retired_ = inst_retired_;
+  stats.slices_ = slices_;
+  stats.steals_ = steals_;
+  stats.seconds_ = std::chrono::duration<double>(end - start).count();
+  return stats;
+}
+
+void MipsBatchRunner::WorkerMain(int worker, int slice_cycles) {
+  while (true) {
+    Job* job = PopLocal(worker);
+    if (job == nullptr) {
+      job = Steal(worker);
+    }
+    if (job == nullptr) {
+      return;
+    }
+    RunJob(job, slice_cycles);
+  }
+}
+
+void MipsBatchRunner::RunJob(Job* job, int slice_cycles) {
+  std::unique_ptr<MipsBatchJob> instance = job->factory_();
+  for (uint64_t spent = 0; spent < job->cycle_budget_;) {
+    int cycle = std::min<uint64_t>(slice_cycles, job->cycle_budget_ - spent);
+    instance->RunSlice(cycle);
+    spent += cycle;
+    slices_.fetch_add(1, std::memory_order_relaxed);
+  }
+  inst_retired_.fetch_add(instance->GetInstRetired(), std::memory_order_relaxed);
+}
+
+MipsBatchRunner::Job* MipsBatchRunner::PopLocal(int worker) {
+  WorkerQueue& queue = *queues_[worker];
+  std::lock_guard<std::mutex> lock(queue.mutex_);
+  if (queue.jobs_.empty()) {
+    return nullptr;
+  }
+  Job* job = queue.jobs_.front();
+  queue.jobs_.pop_front();
+  return job;
+}
+
+MipsBatchRunner::Job* MipsBatchRunner::Steal(int worker) {
+  for (int i = 1; i < thread_count_; i++) {
+    WorkerQueue& victim = *queues_[(worker + i) % thread_count_];
+    std::lock_guard<std::mutex> lock(victim.mutex_);
+    if (!victim.jobs_.empty()) {
+      Job* job = victim.jobs_.back();
+      victim.jobs_.pop_back();
+      steals_.fetch_add(1, std::memory_order_relaxed);
+      return job;
+    }
+  }
+  return nullptr;
+}
@@ -0,0 +1,339 @@
+#include "mips_bus_replay.h"
+
+#include <fmt/format.h>
+
+#include <fstream>
+
+#include "panic.h"
+
+namespace {
+
+const uint32_t kBusLogMagic = 0x5242474E;  // "NGBR"
+const uint32_t kBusLogVersion = 1;
+
+struct BusLogHeader {
+  uint32_t magic_;
+  uint32_t version_;
+  uint64_t loads_size_;
+  uint64_t interrupts_size_;
+};
+
+enum LoadKind {
+  kLoadKind8 = 0,
+  kLoadKind16 = 1,
+  kLoadKind32 = 2,
+  kLoadKind64 = 3,
+  kLoadKindFetch = 4,
+};
+
+void write_varint(std::vector<uint8_t>& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(value);
+}
+
+bool read_varint(const std::vector<uint8_t>& in, size_t& offset, uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (offset >= in.size()) {
+      return false;
+    }
+    uint8_t byte = in[offset++];
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Timestamps normally only grow, but a CPU reset can take them back
+uint64_t encode_delta(uint64_t current, uint64_t previous) {
+  int64_t delta = static_cast<int64_t>(current - previous);
+  return (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+}
+
+uint64_t decode_delta(uint64_t value, uint64_t previous) {
+  int64_t delta = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  return previous + delta;
+}
+
+}  // namespace
+
+bool MipsBusLog::Save(const std::string& path) const {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    fmt::print("Failed to open bus log: {}\n", path);
+    return false;
+  }
+
+  BusLogHeader header;
+  header.magic_ = kBusLogMagic;
+  header.version_ = kBusLogVersion;
+  header.loads_size_ = loads_.size();
+  header.interrupts_size_ = interrupts_.size();
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(loads_.data()), loads_.size());
+  file.write(reinterpret_cast<const char*>(interrupts_.data()), interrupts_.size());
+  return file.good();
+}
+
+bool MipsBusLog::Load(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  BusLogHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+    return false;
+  }
+  if (header.magic_ != kBusLogMagic || header.version_ != kBusLogVersion) {
+    fmt::print("Ignoring incompatible bus log: {}\n", path);
+    return false;
+  }
+
+  loads_.resize(header.loads_size_);
+  interrupts_.resize(header.interrupts_size_);
+  file.read(reinterpret_cast<char*>(loads_.data()), loads_.size());
+  file.read(reinterpret_cast<char*>(interrupts_.data()), interrupts_.size());
+  if (!file) {
+    Clear();
+    return false;
+  }
+  return true;
+}
+
+void MipsBusLog::Clear() {
+  loads_.clear();
+  interrupts_.clear();
+}
+
+MipsRecordingBus::MipsRecordingBus(std::shared_ptr<BusBase> bus) {
+  bus_ = bus;
+  ClearLog();
+}
+
+void MipsRecordingBus::ClearLog() {
+  log_.Clear();
+  last_load_timestamp_ = 0;
+  last_interrupt_timestamp_ = 0;
+  interrupt_calls_ = 0;
+  interrupt_level_ = false;
+}
+
+void MipsRecordingBus::Reset() {
+  bus_->Reset();
+  ClearLog();
+}
+
+LoadResult8 MipsRecordingBus::Load8(uint64_t address) {
+  LoadResult8 result = bus_->Load8(address);
+  if (!ram_ranges_.Contains(address)) {
+    RecordLoad(kLoadKind8, address, result.has_value, result.value);
+  }
+  return result;
+}
+
+LoadResult16 MipsRecordingBus::Load16(uint64_t address) {
+  LoadResult16 result = bus_->Load16(address);
+  if (!ram_ranges_.Contains(address)) {
+    RecordLoad(kLoadKind16, address, result.has_value, result.value);
+  }
+  return result;
+}
+
+LoadResult32 MipsRecordingBus::Load32(uint64_t address) {
+  LoadResult32 result = bus_->Load32(address);
+  if (!ram_ranges_.Contains(address)) {
+    RecordLoad(kLoadKind32, address, result.has_value, result.value);
+  }
+  return result;
+}
+
+LoadResult64 MipsRecordingBus::Load64(uint64_t address) {
+  LoadResult64 result = bus_->Load64(address);
+  if (!ram_ranges_.Contains(address)) {
+    RecordLoad(kLoadKind64, address, result.has_value, result.value);
+  }
+  return result;
+}
+
+uint32_t MipsRecordingBus::Fetch(uint64_t address) {
+  uint32_t result = bus_->Fetch(address);
+  if (!ram_ranges_.Contains(address)) {
+    RecordLoad(kLoadKindFetch, address, true, result);
+  }
+  return result;
+}
+
+bool MipsRecordingBus::GetInterrupt() {
+  bool level = bus_->GetInterrupt();
+  interrupt_calls_++;
+  if (level != interrupt_level_) {
+    uint64_t timestamp = GetTimestamp();
+    write_varint(log_.interrupts_, encode_delta(timestamp, last_interrupt_timestamp_));
+    write_varint(log_.interrupts_, interrupt_calls_);
+    log_.interrupts_.push_back(level ? 1 : 0);
+    last_interrupt_timestamp_ = timestamp;
+    interrupt_calls_ = 0;
+    interrupt_level_ = level;
+  }
+  return level;
+}
+
+void MipsRecordingBus::RecordLoad(int kind, uint64_t address, bool has_value, uint64_t value) {
+  uint64_t timestamp = GetTimestamp();
+  log_.loads_.push_back(kind);
+  write_varint(log_.loads_, encode_delta(timestamp, last_load_timestamp_));
+  write_varint(log_.loads_, address);
+  log_.loads_.push_back(has_value ? 1 : 0);
+  write_varint(log_.loads_, value);
+  last_load_timestamp_ = timestamp;
+}
+
+MipsReplayBus::MipsReplayBus(std::shared_ptr<BusBase> bus, MipsBusLog log) {
+  bus_ = bus;
+  log_ = std::move(log);
+  load_offset_ = 0;
+  interrupt_offset_ = 0;
+  last_load_timestamp_ = 0;
+  last_interrupt_timestamp_ = 0;
+  interrupt_calls_ = 0;
+  interrupt_level_ = false;
+  ReadNextInterrupt();
+}
+
+bool MipsReplayBus::IsFinished() const {
+  return load_offset_ == log_.loads_.size() && !has_next_interrupt_;
+}
+
+void MipsReplayBus::Reset() {
+  bus_->Reset();
+  load_offset_ = 0;
+  interrupt_offset_ = 0;
+  last_load_timestamp_ = 0;
+  last_interrupt_timestamp_ = 0;
+  interrupt_calls_ = 0;
+  interrupt_level_ = false;
+  ReadNextInterrupt();
+}
+
+LoadResult8 MipsReplayBus::Load8(uint64_t address) {
+  if (ram_ranges_.Contains(address)) {
+    return bus_->Load8(address);
+  }
+  LoadResult64 result = ReplayLoad(kLoadKind8, address);
+  return LoadResult8{.has_value = result.has_value, .value = static_cast<uint8_t>(result.value)};
+}
+
+LoadResult16 MipsReplayBus::Load16(uint64_t address) {
+  if (ram_ranges_.Contains(address)) {
+    return bus_->Load16(address);
+  }
+  LoadResult64 result = ReplayLoad(kLoadKind16, address);
+  return LoadResult16{.has_value = result.has_value, .value = static_cast<uint16_t>(result.value)};
+}
+
+LoadResult32 MipsReplayBus::Load32(uint64_t address) {
+  if (ram_ranges_.Contains(address)) {
+    return bus_->Load32(address);
+  }
+  LoadResult64 result = ReplayLoad(kLoadKind32, address);
+  return LoadResult32{.has_value = result.has_value, .value = static_cast<uint32_t>(result.value)};
+}
+
+LoadResult64 MipsReplayBus::Load64(uint64_t address) {
+  if (ram_ranges_.Contains(address)) {
+    return bus_->Load64(address);
+  }
+  return ReplayLoad(kLoadKind64, address);
+}
+
+uint32_t MipsReplayBus::Fetch(uint64_t address) {
+  if (ram_ranges_.Contains(address)) {
+    return bus_->Fetch(address);
+  }
+  return ReplayLoad(kLoadKindFetch, address).value;
+}
+
+bool MipsReplayBus::GetInterrupt() {
+  interrupt_calls_++;
+  if (has_next_interrupt_ && interrupt_calls_ == next_interrupt_call_) {
+    if (cpu_ != nullptr && cpu_->GetTimestamp() != next_interrupt_timestamp_) {
+      PANIC("Bus replay desync: interrupt change at {} expected at {}", cpu_->GetTimestamp(),
+            next_interrupt_timestamp_);
+    }
+    interrupt_level_ = next_interrupt_level_;
+    last_interrupt_timestamp_ = next_interrupt_timestamp_;
+    interrupt_calls_ = 0;
+    ReadNextInterrupt();
+  }
+  return interrupt_level_;
+}
+
+LoadResult64 MipsReplayBus::ReplayLoad(int kind, uint64_t address) {
+  // Keep device side effects of the read; the value comes from the log
+  switch (kind) {
+    case kLoadKind8:
+      bus_->Load8(address);
+      break;
+    case kLoadKind16:
+      bus_->Load16(address);
+      break;
+    case kLoadKind32:
+      bus_->Load32(address);
+      break;
+    case kLoadKind64:
+      bus_->Load64(address);
+      break;
+    default:
+      bus_->Fetch(address);
+      break;
+  }
+
+  const std::vector<uint8_t>& in = log_.loads_;
+  if (load_offset_ >= in.size()) {
+    PANIC("Bus replay desync: log exhausted at load {:08X}", address);
+  }
+  uint8_t recorded_kind = in[load_offset_++];
+  uint64_t timestamp_delta = 0;
+  uint64_t recorded_address = 0;
+  uint64_t value = 0;
+  bool ok = read_varint(in, load_offset_, timestamp_delta) && read_varint(in, load_offset_, recorded_address) &&
+            load_offset_ < in.size();
+  bool has_value = ok && in[load_offset_++] != 0;
+  ok = ok && read_varint(in, load_offset_, value);
+  if (!ok) {
+    PANIC("Bus replay log is truncated");
+  }
+
+  uint64_t timestamp = decode_delta(timestamp_delta, last_load_timestamp_);
+  last_load_timestamp_ = timestamp;
+  if (recorded_kind != kind || recorded_address != address) {
+    PANIC("Bus replay desync: load {} {:08X}, log has {} {:08X}", kind, address, recorded_kind, recorded_address);
+  }
+  if (cpu_ != nullptr && cpu_->GetTimestamp() != timestamp) {
+    PANIC("Bus replay desync: load {:08X} at {}, log has {}", address, cpu_->GetTimestamp(), timestamp);
+  }
+  return LoadResult64{.has_value = has_value, .value = value};
+}
+
+void MipsReplayBus::ReadNextInterrupt() {
+  const std::vector<uint8_t>& in = log_.interrupts_;
+  has_next_interrupt_ = false;
+  if (interrupt_offset_ >= in.size()) {
+    return;
+  }
+
+  uint64_t timestamp_delta = 0;
+  if (!read_varint(in, interrupt_offset_, timestamp_delta) ||
+      !read_varint(in, interrupt_offset_, next_interrupt_call_) || interrupt_offset_ >= in.size()) {
+    PANIC("Bus replay log is truncated");
+  }
+  next_interrupt_level_ = in[interrupt_offset_++] != 0;
+  next_interrupt_timestamp_ = decode_delta(timestamp_delta, last_interrupt_timestamp_);
+  has_next_interrupt_ = true;
+}
@@ -10,9 +10,23 @@
 namespace {
 
 constexpr uint64_t kPhysicalUnmappedAddress = 0xFFFFFFFFFFFFFFFFUL;
+constexpr uint64_t kFnvOffsetBasis = 0xCBF29CE484222325UL;
+constexpr uint64_t kFnvPrime = 0x100000001B3UL;
 
 }  // namespace
 
+uint64_t HashBlockCode(const uint32_t* opcodes, int length) {
+  // FNV-1a over the opcode bytes
+  uint64_t hash = kFnvOffsetBasis;
+  for (int i = 0; i < length; i++) {
+    for (int shamt = 0; shamt < 32; shamt += 8) {
+      hash ^= (opcodes[i] >> shamt) & 0xFF;
+      hash *= kFnvPrime;
+    }
+  }
+  return hash;
+}
+
 #define CACHE_TEMPLATE template <typename MipsT, typename TlbType>
 #define CACHE_CLASS MipsCache<MipsT, TlbType>
 
@@ -42,20 +56,28 @@ void CACHE_CLASS::ConnectTlb(TlbType* tlb) {
 }
 
 CACHE_TEMPLATE
-MipsCacheBlock<MipsT>* CACHE_CLASS::GetBlock(uint64_t address) {
+MipsTlbTranslationResult CACHE_CLASS::Translate(uint64_t address) {
   // Fast path for kseg0/kseg1: avoid virtual TLB call
   address &= 0xFFFFFFFF;
   bool is_kseg0 = address >= 0x80000000 && address < 0xA0000000;
   bool is_kseg1 = address >= 0xA0000000 && address < 0xC0000000;
   if (is_kseg0 || is_kseg1) {
-    address = address & 0x1FFFFFFF;
-  } else {
-    auto result = tlb_->TranslateAddress(address);
-    if (!result.found_) {
-      return nullptr;
-    }
-    address = result.address_;
+    MipsTlbTranslationResult result;
+    result.found_ = true;
+    result.read_only_ = false;
+    result.address_ = address & 0x1FFFFFFF;
+    return result;
   }
+  return tlb_->TranslateAddress(address);
+}
+
+CACHE_TEMPLATE
+MipsCacheBlock<MipsT>* CACHE_CLASS::GetBlock(uint64_t address) {
+  auto result = Translate(address);
+  if (!result.found_) {
+    return nullptr;
+  }
+  address = result.address_;
 
   int idx = static_cast<int>((address >> 2) & (kLookupCacheSize - 1));
   if (lookup_cache_[idx].address_ == address && lookup_cache_[idx].block_ != nullptr) {
@@ -73,7 +95,7 @@ MipsCacheBlock<MipsT>* CACHE_CLASS::GetBlock(uint64_t address) {
 
 CACHE_TEMPLATE
 MipsCacheBlock<MipsT>* CACHE_CLASS::GetOverlappingEntry(uint64_t address) {
-  auto result = tlb_->TranslateAddress(address);
+  auto result = Translate(address);
   if (!result.found_) {
     return nullptr;
   }
@@ -85,7 +107,7 @@ MipsCacheBlock<MipsT>* CACHE_CLASS::GetOverlappingEntry(uint64_t address) {
 CACHE_TEMPLATE
 void CACHE_CLASS::InsertBlock(const MipsCacheBlock<MipsT>& block) {
   MipsCacheBlock<MipsT> block_copy = block;
-  auto result = tlb_->TranslateAddress(block_copy.start_);
+  auto result = Translate(block_copy.start_);
   if (!result.found_) {
     return;
   }
@@ -104,7 +126,7 @@ void CACHE_CLASS::InsertBlock(const MipsCacheBlock<MipsT>& block) {
 
 CACHE_TEMPLATE
 void CACHE_CLASS::InvalidateBlock(uint64_t address) {
-  auto result = tlb_->TranslateAddress(address);
+  auto result = Translate(address);
   if (!result.found_) {
     return;
   }
@@ -135,7 +157,7 @@ void CACHE_CLASS::InvalidateBlock(uint64_t address) {
 
 CACHE_TEMPLATE
 void CACHE_CLASS::InvalidateBlockRange(uint64_t start, uint64_t end) {
-  auto result = tlb_->TranslateAddress(start);
+  auto result = Translate(start);
   if (!result.found_) {
     return;
   }
@@ -152,6 +174,22 @@ void CACHE_CLASS::InvalidateBlockRange(uint64_t start, uint64_t end) {
   }
 }
 
+CACHE_TEMPLATE
+void CACHE_CLASS::InvalidatePhysicalRange(uint64_t start, uint64_t end) {
+  for (auto& [block_start, block] : cache_) {
+    if (block.start_ < end && block.end_ > start) {
+      pending_invalidations_.insert(block.start_);
+      has_pending_work_ = true;
+    }
+  }
+}
+
+CACHE_TEMPLATE
+void CACHE_CLASS::InvalidatePhysicalBlock(uint64_t start) {
+  pending_invalidations_.insert(start);
+  has_pending_work_ = true;
+}
+
 CACHE_TEMPLATE
 void CACHE_CLASS::QueueCacheClear() {
   full_clear_queued_ = true;
@@ -197,6 +235,33 @@ void CACHE_CLASS::ExecuteCacheClear() {
   }
 }
 
+CACHE_TEMPLATE
+std::vector<MipsCacheBlockRecord> CACHE_CLASS::ExportBlocks() {
+  std::vector<MipsCacheBlockRecord> records;
+  records.reserve(cache_.size());
+  for (const auto& [start, block] : cache_) {
+    uint32_t opcodes[kCacheBlockMaxLength];
+    for (int i = 0; i < block.length_; i++) {
+      opcodes[i] = block.entries_[i].opcode_;
+    }
+    MipsCacheBlockRecord record;
+    record.address_ = block.entries_[0].address_;
+    record.start_ = block.start_;
+    record.length_ = block.length_;
+    record.reserved_ = 0;
+    record.hash_ = HashBlockCode(opcodes, block.length_);
+    records.push_back(record);
+  }
+  return records;
+}
+
 // Explicit instantiations — keep definitions out of other TUs
 template class MipsCache<N64Mips, MipsTlbNormal>;
-template class MipsCache<RspMips, MipsTlbDummy>;
+template class MipsCache<PsxMips, MipsTlbDummy>;
+
+#ifdef NGMIPS_BUS_INSTANTIATIONS
+#define NGMIPS_INSTANTIATE(TlbType, kIs64Bit, kHasLoadDelay, kHasCop0, BusType) \
+  template class MipsCache<MipsBase<TlbType, kIs64Bit, kHasLoadDelay, kHasCop0, BusType>, TlbType>;
+#include NGMIPS_BUS_INSTANTIATIONS
+#undef NGMIPS_INSTANTIATE
+#endif
@@ -3,24 +3,14 @@
 #include <fmt/core.h>
 
 #include "mips_base.h"
+#include "mips_state.h"
 #include "panic.h"
 
 namespace {
 
 const bool kLogCop = false;
 
-uint32_t xorshift_state = 1;
-
-void init_xorshift(uint32_t seed) {
-  xorshift_state = 1;
-}
-
-uint32_t xorshift() {
-  xorshift_state ^= xorshift_state << 13;
-  xorshift_state ^= xorshift_state >> 17;
-  xorshift_state ^= xorshift_state << 5;
-  return xorshift_state;
-}
+const uint32_t kRandomSeed = 1;
 
 }  // namespace
 
@@ -36,6 +26,7 @@ MipsCop0::MipsCop0() {
   count_start_timestamp_ = 0;
   last_compare_check_timestamp_ = 0;
   surpress_compare_interrupt_ = false;
+  random_state_ = kRandomSeed;
 }
 
 void MipsCop0::ConnectCpu(MipsInterface* cpu) {
@@ -54,6 +45,7 @@ void MipsCop0::Reset() {
   count_start_timestamp_ = 0;
   last_compare_check_timestamp_ = 0;
   surpress_compare_interrupt_ = false;
+  random_state_ = kRandomSeed;
 }
 
 void MipsCop0::Command(uint32_t command) {
@@ -127,7 +119,7 @@ uint32_t MipsCop0::Read32(int idx) {
     case 1:
       // NOTE: in theory, one can get REALLY unlucky...
       while (1) {
-        uint32_t rn = xorshift() & 0x1F;
+        uint32_t rn = NextRandom() & 0x1F;
         if (rn >= wired_) {
           return rn;
         }
@@ -244,7 +236,7 @@ uint64_t MipsCop0::Read64(int idx) {
       return tlb->GetIndex();
     case 1:
       while (1) {
-        uint32_t rn = xorshift() & 0x1F;
+        uint32_t rn = NextRandom() & 0x1F;
         if (rn >= wired_) {
           return rn;
         }
@@ -444,6 +436,67 @@ bool MipsCop0::GetFlag() {
   return false;
 }
 
+void MipsCop0::SaveState(MipsStateWriter& writer) {
+  writer.Write(context_);
+  writer.Write(wired_);
+  writer.Write(badvaddr_);
+  writer.Write(compare_);
+  writer.Write(sr_);
+  writer.Write(cause_);
+  writer.Write(epc_);
+  writer.Write(error_epc_);
+  writer.Write(count_start_timestamp_);
+  writer.Write(last_compare_check_timestamp_);
+  writer.Write<uint8_t>(surpress_compare_interrupt_);
+  writer.Write(random_state_);
+}
+
+bool MipsCop0::LoadState(MipsStateReader& reader, bool commit) {
+  uint64_t context = 0;
+  uint32_t wired = 0;
+  uint64_t badvaddr = 0;
+  uint32_t compare = 0;
+  uint32_t sr = 0;
+  uint32_t cause = 0;
+  uint64_t epc = 0;
+  uint64_t error_epc = 0;
+  uint64_t count_start_timestamp = 0;
+  uint64_t last_compare_check_timestamp = 0;
+  uint8_t surpress_compare_interrupt = 0;
+  uint32_t random_state = 0;
+  reader.Read(context);
+  reader.Read(wired);
+  reader.Read(badvaddr);
+  reader.Read(compare);
+  reader.Read(sr);
+  reader.Read(cause);
+  reader.Read(epc);
+  reader.Read(error_epc);
+  reader.Read(count_start_timestamp);
+  reader.Read(last_compare_check_timestamp);
+  reader.Read(surpress_compare_interrupt);
+  reader.Read(random_state);
+  if (!reader.IsGood()) {
+    return false;
+  }
+
+  if (commit) {
+    context_ = context;
+    wired_ = wired;
+    badvaddr_ = badvaddr;
+    compare_ = compare;
+    sr_ = sr;
+    cause_ = cause;
+    epc_ = epc;
+    error_epc_ = error_epc;
+    count_start_timestamp_ = count_start_timestamp;
+    last_compare_check_timestamp_ = last_compare_check_timestamp;
+    surpress_compare_interrupt_ = surpress_compare_interrupt != 0;
+    random_state_ = random_state;
+  }
+  return true;
+}
+
 bool MipsCop0::CheckCompareInterrupt() {
   uint64_t timestamp = cpu_->GetTimestamp() >> 1;
   if (surpress_compare_interrupt_) {
@@ -495,6 +548,14 @@ void MipsCop0::WriteCount(uint32_t value) {
   surpress_compare_interrupt_ = true;
 }
 
+uint32_t MipsCop0::NextRandom() {
+  // Per-instance xorshift so CPUs on different threads don't share state
+  random_state_ ^= random_state_ << 13;
+  random_state_ ^= random_state_ >> 17;
+  random_state_ ^= random_state_ << 5;
+  return random_state_;
+}
+
 uint32_t MipsCop0::GetCount() {
   uint64_t timestamp = cpu_->GetTimestamp() >> 1;
   if (timestamp < count_start_timestamp_) {
@@ -17,11 +17,14 @@ class MipsCop0 : public MipsCopBase {
   uint64_t Read64Internal(int idx) override;
   void Write64Internal(int idx, uint64_t value) override;
   bool GetFlag() override;
+  void SaveState(MipsStateWriter& writer) override;
+  bool LoadState(MipsStateReader& reader, bool commit) override;
   bool CheckCompareInterrupt();
 
  private:
   void WriteCount(uint32_t value);
   uint32_t GetCount();
+  uint32_t NextRandom();
 
   MipsInterface* cpu_;
 
@@ -37,4 +40,5 @@ class MipsCop0 : public MipsCopBase {
   uint64_t count_start_timestamp_;
   uint64_t last_compare_check_timestamp_;
   bool surpress_compare_interrupt_;
+  uint32_t random_state_;
 };
\ No newline at end of file
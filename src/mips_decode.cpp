@@ -317,7 +317,11 @@ MipsInstId Decode(uint32_t opcode) {
 }
 
 std::string GetInstName(uint32_t opcode) {
-  switch (Decode(opcode)) {
+  return GetInstIdName(Decode(opcode));
+}
+
+const char* GetInstIdName(MipsInstId id) {
+  switch (id) {
     case MipsInstId::kAdd:
       return "add";
     case MipsInstId::kAddu:
@@ -0,0 +1,173 @@
+#include "mips_flat_cache.h"
+
+#include <algorithm>
+
+#include "mips_base.h"
+
+// Bring in TLB types so they're complete for explicit instantiation
+#include "mips_tlb_dummy.h"
+#include "mips_tlb_normal.h"
+
+#define CACHE_TEMPLATE template <typename MipsT, typename TlbType>
+#define CACHE_CLASS MipsFlatCache<MipsT, TlbType>
+
+CACHE_TEMPLATE
+CACHE_CLASS::MipsFlatCache() {
+  for (int i = 0; i < kFlatCacheSlotCount; i++) {
+    tags_[i] = kInvalidTag;
+  }
+}
+
+CACHE_TEMPLATE
+void CACHE_CLASS::Reset() {
+  for (int i = 0; i < kFlatCacheSlotCount; i++) {
+    tags_[i] = kInvalidTag;
+  }
+  size_ = 0;
+  has_pending_work_ = false;
+}
+
+CACHE_TEMPLATE
+void CACHE_CLASS::ConnectTlb(TlbType* tlb) {
+  tlb_ = tlb;
+}
+
+CACHE_TEMPLATE
+MipsCacheBlock<MipsT>* CACHE_CLASS::GetBlock(uint64_t address) {
+  auto result = tlb_->TranslateAddress(address & 0xFFFFFFFF);
+  if (!result.found_) {
+    return nullptr;
+  }
+
+  int slot = GetSlot(result.address_);
+  if (tags_[slot] != result.address_) {
+    return nullptr;
+  }
+  return blocks_[slot].get();
+}
+
+CACHE_TEMPLATE
+void CACHE_CLASS::InsertBlock(const MipsCacheBlock<MipsT>& block) {
+  auto result = tlb_->TranslateAddress(block.start_);
+  if (!result.found_) {
+    return;
+  }
+
+  int slot = GetSlot(result.address_);
+  if (blocks_[slot] == nullptr) {
+    blocks_[slot] = std::make_unique<MipsCacheBlock<MipsT>>();
+  }
+  if (tags_[slot] == kInvalidTag) {
+    size_++;
+  }
+
+  // Only the used entries are copied; the rest of the slot keeps stale data
+  MipsCacheBlock<MipsT>& target = *blocks_[slot];
+  uint64_t offset = block.end_ - block.start_;
+  target.start_ = result.address_;
+  target.end_ = result.address_ + offset;
+  std::copy(block.entries_, block.entries_ + block.length_, target.entries_);
+  target.length_ = block.length_;
+  target.cycle_ = block.cycle_;
+  target.has_load_hazard_ = block.has_load_hazard_;
+  target.profile_ = block.profile_;
+  tags_[slot] = result.address_;
+}
+
+CACHE_TEMPLATE
+void CACHE_CLASS::InvalidateSlot(int slot) {
+  if (tags_[slot] != kInvalidTag) {
+    tags_[slot] = kInvalidTag;
+    size_--;
+  }
+}
+
+CACHE_TEMPLATE
+void CACHE_CLASS::InvalidateBlock(uint64_t address) {
+  auto result = tlb_->TranslateAddress(address);
+  if (!result.found_) {
+    return;
+  }
+  InvalidatePhysicalRange(result.address_, result.address_ + 4);
+}
+
+CACHE_TEMPLATE
+void CACHE_CLASS::InvalidateBlockRange(uint64_t start, uint64_t end) {
+  auto result = tlb_->TranslateAddress(start);
+  if (!result.found_) {
+    return;
+  }
+  InvalidatePhysicalRange(result.address_, result.address_ + (end - start));
+}
+
+CACHE_TEMPLATE
+void CACHE_CLASS::InvalidatePhysicalBlock(uint64_t start) {
+  int slot = GetSlot(start);
+  if (tags_[slot] == start) {
+    InvalidateSlot(slot);
+  }
+}
+
+CACHE_TEMPLATE
+void CACHE_CLASS::InvalidatePhysicalRange(uint64_t start, uint64_t end) {
+  // A block covering [start, end) starts at most kCacheBlockMaxLength - 1
+  // words before it. Slots are only touched here; a block that is running
+  // keeps its entries until it finishes, as with MipsCache.
+  uint64_t first = start & ~3ULL;
+  uint64_t lookback = (kCacheBlockMaxLength - 1) * 4;
+  first = first >= lookback ? first - lookback : 0;
+  if (end - first >= kFlatCacheSlotCount * 4ULL) {
+    for (int slot = 0; slot < kFlatCacheSlotCount; slot++) {
+      if (tags_[slot] != kInvalidTag && blocks_[slot]->start_ < end && blocks_[slot]->end_ > start) {
+        InvalidateSlot(slot);
+      }
+    }
+    return;
+  }
+  for (uint64_t address = first; address < end; address += 4) {
+    int slot = GetSlot(address);
+    if (tags_[slot] == address && blocks_[slot]->end_ > start) {
+      InvalidateSlot(slot);
+    }
+  }
+}
+
+CACHE_TEMPLATE
+void CACHE_CLASS::QueueCacheClear() {
+  has_pending_work_ = true;
+}
+
+CACHE_TEMPLATE
+void CACHE_CLASS::ExecuteCacheClear() {
+  Reset();
+}
+
+CACHE_TEMPLATE
+std::vector<MipsCacheBlockRecord> CACHE_CLASS::ExportBlocks() {
+  std::vector<MipsCacheBlockRecord> records;
+  records.reserve(size_);
+  ForEachBlock([&](const MipsCacheBlock<MipsT>& block) {
+    uint32_t opcodes[kCacheBlockMaxLength];
+    for (int i = 0; i < block.length_; i++) {
+      opcodes[i] = block.entries_[i].opcode_;
+    }
+    MipsCacheBlockRecord record;
+    record.address_ = block.entries_[0].address_;
+    record.start_ = block.start_;
+    record.length_ = block.length_;
+    record.reserved_ = 0;
+    record.hash_ = HashBlockCode(opcodes, block.length_);
+    records.push_back(record);
+  });
+  return records;
+}
+
+// Explicit instantiations — keep definitions out of other TUs
+template class MipsFlatCache<RspMips, MipsTlbDummy>;
+
+#ifdef NGMIPS_BUS_INSTANTIATIONS
+#define NGMIPS_INSTANTIATE(TlbType, kIs64Bit, kHasLoadDelay, kHasCop0, BusType) \
+  template class MipsFlatCache<MipsBase<TlbType, kIs64Bit, kHasLoadDelay, kHasCop0, BusType>, TlbType>;
+#include NGMIPS_BUS_INSTANTIATIONS
+#undef NGMIPS_INSTANTIATE
+#endif
@@ -3,8 +3,10 @@
 #include <fmt/format.h>
 
 #include <cmath>
+#include <cstring>
 
 #include "mips_base.h"
+#include "mips_state.h"
 #include "panic.h"
 
 namespace {
@@ -298,6 +300,27 @@ bool MipsFpu::GetFlag() {
   return (fcr31_ & (1 << 23)) != 0;
 }
 
+void MipsFpu::SaveState(MipsStateWriter& writer) {
+  writer.Write(fpr_);
+  writer.Write(fcr31_);
+}
+
+bool MipsFpu::LoadState(MipsStateReader& reader, bool commit) {
+  uint64_t fpr[32];
+  uint32_t fcr31 = 0;
+  reader.Read(fpr);
+  reader.Read(fcr31);
+  if (!reader.IsGood()) {
+    return false;
+  }
+
+  if (commit) {
+    std::memcpy(fpr_, fpr, sizeof(fpr_));
+    fcr31_ = fcr31;
+  }
+  return true;
+}
+
 float MipsFpu::ReadF32(int idx) {
   uint32_t value = ReadI32(idx);
   return *reinterpret_cast<f32_t*>(&value);
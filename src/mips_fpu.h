@@ -21,6 +21,8 @@ class MipsFpu : public MipsCopBase {
   uint64_t Read64Internal(int idx) override { return 0; }
   void Write64Internal(int idx, uint64_t value) override {}
   bool GetFlag() override;
+  void SaveState(MipsStateWriter& writer) override;
+  bool LoadState(MipsStateReader& reader, bool commit) override;
 
  private:
   float ReadF32(int idx);
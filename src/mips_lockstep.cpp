@@ -0,0 +1,178 @@
+#include "mips_lockstep.h"
+
+#include <fmt/format.h>
+
+#include "mips_decode.h"
+
+namespace {
+
+// COP0 registers compared at block boundaries. Random (1) is skipped since
+// reading it advances the generator.
+const int kLockstepCop0Regs[] = {0, 2, 3, 4, 5, 6, 8, 9, 10, 11, 12, 13, 14, 30};
+
+const char* kGprNames[32] = {
+    "zero", "at", "v0", "v1", "a0", "a1", "a2", "a3",
+    "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7",
+    "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7",
+    "t8", "t9", "k0", "k1", "gp", "sp", "fp", "ra"};
+
+}  // namespace
+
+template <typename MipsT>
+MipsLockstep<MipsT>::MipsLockstep(MipsConfig config, std::shared_ptr<BusBase> plain_bus,
+                                  std::shared_ptr<BusBase> cached_bus) {
+  config_ = config;
+  plain_bus_ = plain_bus;
+  cached_bus_ = cached_bus;
+
+  MipsConfig plain_config = config;
+  plain_config.use_cached_interpreter_ = false;
+  plain_ = std::make_unique<MipsT>(plain_config);
+  plain_->ConnectBus(plain_bus_);
+
+  MipsConfig cached_config = config;
+  cached_config.use_cached_interpreter_ = true;
+  cached_ = std::make_unique<MipsT>(cached_config);
+  cached_->ConnectBus(cached_bus_);
+
+  step_ = 0;
+  step_start_pc_ = 0;
+  has_diverged_ = false;
+  divergence_ = MipsLockstepDivergence();
+}
+
+template <typename MipsT>
+void MipsLockstep<MipsT>::Reset() {
+  plain_->Reset();
+  cached_->Reset();
+  step_ = 0;
+  step_start_pc_ = 0;
+  step_trace_.clear();
+  has_diverged_ = false;
+  divergence_ = MipsLockstepDivergence();
+}
+
+template <typename MipsT>
+void MipsLockstep<MipsT>::SetPc(uint64_t pc) {
+  plain_->SetPc(pc);
+  cached_->SetPc(pc);
+}
+
+template <typename MipsT>
+bool MipsLockstep<MipsT>::Step() {
+  if (has_diverged_) {
+    return false;
+  }
+
+  plain_->CheckInterrupt();
+  plain_->CheckCompare();
+  cached_->CheckInterrupt();
+  cached_->CheckCompare();
+
+  step_start_pc_ = cached_->GetPc();
+  step_trace_.clear();
+
+  // RunBlock does not poll interrupts, so the polls above are the only
+  // ones on either side
+  cached_->RunBlock();
+  const uint64_t target = cached_->GetInstRetired();
+  while (plain_->GetInstRetired() < target && !plain_->GetHalt()) {
+    step_trace_.push_back(plain_->GetPc());
+    plain_->RunInst();
+  }
+
+  step_++;
+  return Compare();
+}
+
+template <typename MipsT>
+uint64_t MipsLockstep<MipsT>::Run(uint64_t max_steps) {
+  uint64_t steps = 0;
+  while (steps < max_steps && !cached_->GetHalt()) {
+    if (!Step()) {
+      break;
+    }
+    steps++;
+  }
+  return steps;
+}
+
+template <typename MipsT>
+bool MipsLockstep<MipsT>::Compare() {
+  if (!CompareValue("inst_retired", plain_->GetInstRetired(), cached_->GetInstRetired())) {
+    return false;
+  }
+  if (!CompareValue("pc", plain_->GetPc(), cached_->GetPc())) {
+    return false;
+  }
+  for (int i = 0; i < 32; i++) {
+    if (!CompareValue(kGprNames[i], plain_->GetGpr(i), cached_->GetGpr(i))) {
+      return false;
+    }
+  }
+  if (!CompareValue("hi", plain_->GetHi(), cached_->GetHi())) {
+    return false;
+  }
+  if (!CompareValue("lo", plain_->GetLo(), cached_->GetLo())) {
+    return false;
+  }
+  if (!CompareValue("halt", plain_->GetHalt(), cached_->GetHalt())) {
+    return false;
+  }
+  if (config_.has_cop0_) {
+    MipsCopBase* plain_cop0 = plain_->GetCop(0);
+    MipsCopBase* cached_cop0 = cached_->GetCop(0);
+    for (int idx : kLockstepCop0Regs) {
+      if (!CompareValue(fmt::format("cop0r{}", idx), plain_cop0->Read64(idx), cached_cop0->Read64(idx))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <typename MipsT>
+bool MipsLockstep<MipsT>::CompareValue(const std::string& name, uint64_t plain_value, uint64_t cached_value) {
+  if (plain_value == cached_value) {
+    return true;
+  }
+  has_diverged_ = true;
+  divergence_.step_ = step_;
+  divergence_.inst_retired_ = plain_->GetInstRetired();
+  divergence_.register_name_ = name;
+  divergence_.plain_value_ = plain_value;
+  divergence_.cached_value_ = cached_value;
+  return false;
+}
+
+template <typename MipsT>
+void MipsLockstep<MipsT>::DumpDivergence() {
+  if (!has_diverged_) {
+    fmt::print("Lockstep: no divergence after {} steps\n", step_);
+    return;
+  }
+
+  fmt::print("===== Lockstep divergence =====\n");
+  fmt::print("Step: {} | Inst retired: {} | Block: {:08X}\n", divergence_.step_, divergence_.inst_retired_,
+             step_start_pc_);
+  fmt::print("{}: plain {:016X} | cached {:016X}\n", divergence_.register_name_, divergence_.plain_value_,
+             divergence_.cached_value_);
+
+  // Instructions the plain interpreter executed during the diverging step
+  for (uint64_t address : step_trace_) {
+    MipsTlbTranslationResult tlb_result = plain_->GetTlb()->TranslateAddress(address);
+    if (!tlb_result.found_) {
+      fmt::print("{:08X} | (unmapped)\n", address & 0xFFFFFFFF);
+      continue;
+    }
+    uint32_t opcode = plain_bus_->Fetch(tlb_result.address_);
+    fmt::print("{:08X} | {:08X} | {}\n", address & 0xFFFFFFFF, opcode, MipsInst(opcode).Disassemble(address));
+  }
+  fmt::print("PC after step: plain {:08X} | cached {:08X}\n", plain_->GetPc() & 0xFFFFFFFF,
+             cached_->GetPc() & 0xFFFFFFFF);
+}
+
+// Explicit instantiations — keep definitions out of other TUs
+template class MipsLockstep<N64Mips>;
+template class MipsLockstep<RspMips>;
+template class MipsLockstep<PsxMips>;
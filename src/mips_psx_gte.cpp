@@ -0,0 +1,760 @@
+#include "mips_psx_gte.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+#include "mips_state.h"
+#include "panic.h"
+
+namespace {
+
+// FLAG bits; the MAC1-3, IR1-3 and color bits are per component, index 1-3
+uint32_t flag_mac_positive(int index) {
+  return 1u << (31 - index);
+}
+
+uint32_t flag_mac_negative(int index) {
+  return 1u << (28 - index);
+}
+
+uint32_t flag_ir(int index) {
+  return 1u << (25 - index);
+}
+
+uint32_t flag_color(int index) {
+  return 1u << (22 - index);
+}
+
+const uint32_t kFlagSz = 1 << 18;
+const uint32_t kFlagDivide = 1 << 17;
+const uint32_t kFlagMac0Positive = 1 << 16;
+const uint32_t kFlagMac0Negative = 1 << 15;
+const uint32_t kFlagSx = 1 << 14;
+const uint32_t kFlagSy = 1 << 13;
+const uint32_t kFlagIr0 = 1 << 12;
+// Bits that also set bit 31
+const uint32_t kFlagErrorMask = 0x7F87E000;
+const uint32_t kFlagWritableMask = 0x7FFFF000;
+
+const int64_t kMacMax = 0x7FFFFFFFFFF;
+const int64_t kMacMin = -0x80000000000;
+
+// A translation this small cannot take a row sum out of 44 bits: three
+// products add at most 3 << 30
+const int64_t kSafeTranslation = 0x7FF00000;
+
+// Reciprocal seeds for the UNR divider, indexed by the top bits of the
+// normalized divisor
+const std::array<uint8_t, 0x101> kUnrTable = []() {
+  std::array<uint8_t, 0x101> table{};
+  for (int i = 0; i < 0x101; i++) {
+    table[i] = static_cast<uint8_t>(std::max(0, (0x40000 / (i + 0x100) + 1) / 2 - 0x101));
+  }
+  return table;
+}();
+
+int64_t sext44(int64_t value) {
+  return static_cast<int64_t>(static_cast<uint64_t>(value) << 20) >> 20;
+}
+
+// low = sum and high = sum >> 12, both truncated to 32 bits, where row r's
+// sum is t[r] * 0x1000 + m[0][r] * vx + m[1][r] * vy + m[2][r] * vz.
+// Registers only ever see these two views of a sum, and neither depends on
+// bits 44 and up, so wrapping there does not change them.
+#if defined(__SSE4_1__)
+
+void multiply_rows(const int32_t (*m)[4], const int32_t* t, int16_t vx, int16_t vy, int16_t vz, int32_t* low,
+                   int32_t* high) {
+  __m128i translation = _mm_load_si128(reinterpret_cast<const __m128i*>(t));
+  __m128i p0 = _mm_mullo_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(m[0])), _mm_set1_epi32(vx));
+  __m128i p1 = _mm_mullo_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(m[1])), _mm_set1_epi32(vy));
+  __m128i p2 = _mm_mullo_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(m[2])), _mm_set1_epi32(vz));
+
+  __m128i sum = _mm_add_epi32(_mm_slli_epi32(translation, 12), _mm_add_epi32(p0, _mm_add_epi32(p1, p2)));
+  _mm_store_si128(reinterpret_cast<__m128i*>(low), sum);
+
+  // Each product fits in 31 bits but their sum may not, so the products are
+  // shifted one by one and the carry out of their low 12 bits added back
+  __m128i fraction_mask = _mm_set1_epi32(0xFFF);
+  __m128i fraction = _mm_add_epi32(_mm_and_si128(p0, fraction_mask),
+                                   _mm_add_epi32(_mm_and_si128(p1, fraction_mask), _mm_and_si128(p2, fraction_mask)));
+  __m128i whole = _mm_add_epi32(_mm_srai_epi32(p0, 12), _mm_add_epi32(_mm_srai_epi32(p1, 12), _mm_srai_epi32(p2, 12)));
+  __m128i shifted = _mm_add_epi32(translation, _mm_add_epi32(whole, _mm_srli_epi32(fraction, 12)));
+  _mm_store_si128(reinterpret_cast<__m128i*>(high), shifted);
+}
+
+// Clamps rows 0-2 into ir and returns a bit for each row that was clamped
+uint32_t saturate_rows(const int32_t* mac, bool lm, int32_t* ir) {
+  __m128i value = _mm_load_si128(reinterpret_cast<const __m128i*>(mac));
+  __m128i clamped = _mm_min_epi32(_mm_max_epi32(value, _mm_set1_epi32(lm ? 0 : -0x8000)), _mm_set1_epi32(0x7FFF));
+  _mm_store_si128(reinterpret_cast<__m128i*>(ir), clamped);
+  return ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(clamped, value))) & 7;
+}
+
+#else
+
+void multiply_rows(const int32_t (*m)[4], const int32_t* t, int16_t vx, int16_t vy, int16_t vz, int32_t* low,
+                   int32_t* high) {
+  for (int row = 0; row < 3; row++) {
+    int64_t sum = (static_cast<int64_t>(t[row]) << 12) + static_cast<int64_t>(m[0][row]) * vx +
+                  static_cast<int64_t>(m[1][row]) * vy + static_cast<int64_t>(m[2][row]) * vz;
+    low[row] = static_cast<int32_t>(sum);
+    high[row] = static_cast<int32_t>(sum >> 12);
+  }
+}
+
+uint32_t saturate_rows(const int32_t* mac, bool lm, int32_t* ir) {
+  uint32_t clamped = 0;
+  for (int row = 0; row < 3; row++) {
+    ir[row] = std::clamp(mac[row], lm ? 0 : -0x8000, 0x7FFF);
+    clamped |= ir[row] != mac[row] ? 1 << row : 0;
+  }
+  return clamped;
+}
+
+#endif
+
+}  // namespace
+
+MipsPsxGte::MipsPsxGte(bool skip_overflow_flags) : skip_overflow_flags_(skip_overflow_flags) {
+#if defined(__SSE4_1__) && (defined(__GNUC__) || defined(__clang__))
+  if (!__builtin_cpu_supports("sse4.1")) {
+    PANIC("GTE was built with SSE4.1 but the host does not support it");
+  }
+#endif
+  Reset();
+}
+
+void MipsPsxGte::Reset() {
+  std::memset(data_, 0, sizeof(data_));
+  std::memset(control_, 0, sizeof(control_));
+  flag_ = 0;
+  UpdateAllUnpacked();
+}
+
+uint32_t MipsPsxGte::Read32(int idx) {
+  if (idx >= 32) {
+    return control_[idx - 32];
+  }
+  switch (idx) {
+    case 15:  // SXYP mirrors SXY2
+      return data_[14];
+    case 28:  // IRGB and ORGB both read back the packed IR1-3
+    case 29:
+      return GetOrgb();
+    default:
+      return data_[idx];
+  }
+}
+
+void MipsPsxGte::Write32(int idx, uint32_t value) {
+  if (idx >= 32) {
+    idx -= 32;
+    switch (idx) {
+      // RT33, L33, LR33, H, DQA, ZSF3 and ZSF4 are 16-bit and read back
+      // sign-extended, even H, which is used unsigned
+      case 4:
+      case 12:
+      case 20:
+      case 26:
+      case 27:
+      case 29:
+      case 30:
+        control_[idx] = static_cast<int16_t>(value);
+        break;
+      case 31:
+        value &= kFlagWritableMask;
+        control_[idx] = value | ((value & kFlagErrorMask) ? 0x80000000 : 0);
+        break;
+      default:
+        control_[idx] = value;
+        break;
+    }
+    UpdateUnpacked(idx);
+    return;
+  }
+
+  switch (idx) {
+    case 1:  // VZ0-2 and IR0-3 are signed 16-bit
+    case 3:
+    case 5:
+    case 8:
+    case 9:
+    case 10:
+    case 11:
+      data_[idx] = static_cast<int16_t>(value);
+      break;
+    case 7:  // OTZ and SZ0-3 are unsigned 16-bit
+    case 16:
+    case 17:
+    case 18:
+    case 19:
+      data_[idx] = static_cast<uint16_t>(value);
+      break;
+    case 15:  // SXYP pushes onto the screen XY FIFO
+      data_[12] = data_[13];
+      data_[13] = data_[14];
+      data_[14] = value;
+      break;
+    case 28:  // IRGB expands 5-bit color into IR1-3
+      data_[9] = (value & 0x1F) << 7;
+      data_[10] = ((value >> 5) & 0x1F) << 7;
+      data_[11] = ((value >> 10) & 0x1F) << 7;
+      break;
+    case 29:  // ORGB and LZCR are read-only
+    case 31:
+      break;
+    case 30:  // LZCS; LZCR counts its leading sign bits
+      data_[30] = value;
+      data_[31] = static_cast<int32_t>(value) < 0 ? std::countl_one(value) : std::countl_zero(value);
+      break;
+    default:
+      data_[idx] = value;
+      break;
+  }
+}
+
+void MipsPsxGte::Command(uint32_t command) {
+  bool sf = command & (1 << 19);
+  bool lm = command & (1 << 10);
+  flag_ = 0;
+
+  switch (command & 0x3F) {
+    case 0x01:
+      Rtps(0, sf, lm, true);
+      break;
+    case 0x06:
+      Nclip();
+      break;
+    case 0x0C:
+      Op(sf, lm);
+      break;
+    case 0x10:
+      Dpcs(data_[6], sf, lm);
+      break;
+    case 0x11:
+      Intpl(sf, lm);
+      break;
+    case 0x12:
+      Mvmva(command);
+      break;
+    case 0x13:
+      Ncds(0, sf, lm);
+      break;
+    case 0x14:
+      Cdp(sf, lm);
+      break;
+    case 0x16:  // NCDT
+      Ncds(0, sf, lm);
+      Ncds(1, sf, lm);
+      Ncds(2, sf, lm);
+      break;
+    case 0x1B:
+      Nccs(0, sf, lm);
+      break;
+    case 0x1C:
+      Cc(sf, lm);
+      break;
+    case 0x1E:
+      Ncs(0, sf, lm);
+      break;
+    case 0x20:  // NCT
+      Ncs(0, sf, lm);
+      Ncs(1, sf, lm);
+      Ncs(2, sf, lm);
+      break;
+    case 0x28:
+      Sqr(sf, lm);
+      break;
+    case 0x29:
+      Dcpl(sf, lm);
+      break;
+    case 0x2A:  // DPCT works through the color FIFO
+      Dpcs(data_[20], sf, lm);
+      Dpcs(data_[20], sf, lm);
+      Dpcs(data_[20], sf, lm);
+      break;
+    case 0x2D:  // AVSZ3
+      Avsz(static_cast<int16_t>(control_[29]), 3);
+      break;
+    case 0x2E:  // AVSZ4
+      Avsz(static_cast<int16_t>(control_[30]), 4);
+      break;
+    case 0x30:  // RTPT
+      Rtps(0, sf, lm, false);
+      Rtps(1, sf, lm, false);
+      Rtps(2, sf, lm, true);
+      break;
+    case 0x3D:
+      Gpf(sf, lm);
+      break;
+    case 0x3E:
+      Gpl(sf, lm);
+      break;
+    case 0x3F:  // NCCT
+      Nccs(0, sf, lm);
+      Nccs(1, sf, lm);
+      Nccs(2, sf, lm);
+      break;
+    default:
+      fmt::print("Unknown GTE command: {:08X}\n", command);
+      break;
+  }
+
+  control_[31] = flag_ | ((flag_ & kFlagErrorMask) ? 0x80000000 : 0);
+}
+
+void MipsPsxGte::SaveState(MipsStateWriter& writer) {
+  writer.Write(data_);
+  writer.Write(control_);
+}
+
+bool MipsPsxGte::LoadState(MipsStateReader& reader, bool commit) {
+  uint32_t data[32];
+  uint32_t control[32];
+  reader.Read(data);
+  reader.Read(control);
+  if (!reader.IsGood()) {
+    return false;
+  }
+
+  if (commit) {
+    std::memcpy(data_, data, sizeof(data_));
+    std::memcpy(control_, control, sizeof(control_));
+    UpdateAllUnpacked();
+  }
+  return true;
+}
+
+void MipsPsxGte::Rtps(int vector, bool sf, bool lm, bool is_last) {
+  int32_t z = Transform(kRotation, kTranslation, GetVector(vector, 0), GetVector(vector, 1), GetVector(vector, 2), sf,
+                        lm, true);
+  PushSz(z);
+
+  int64_t n = Divide();
+  int64_t x = n * GetIr(1) + static_cast<int32_t>(control_[24]);
+  int64_t y = n * GetIr(2) + static_cast<int32_t>(control_[25]);
+  SetMac0(x);
+  SetMac0(y);
+  PushSxy(static_cast<int32_t>(x >> 16), static_cast<int32_t>(y >> 16));
+
+  if (is_last) {
+    int64_t depth = n * static_cast<int16_t>(control_[27]) + static_cast<int32_t>(control_[28]);
+    SetMac0(depth);
+    SetIr0(static_cast<int32_t>(depth >> 12));
+  }
+}
+
+void MipsPsxGte::Nclip() {
+  int64_t x0 = static_cast<int16_t>(data_[12]);
+  int64_t y0 = static_cast<int16_t>(data_[12] >> 16);
+  int64_t x1 = static_cast<int16_t>(data_[13]);
+  int64_t y1 = static_cast<int16_t>(data_[13] >> 16);
+  int64_t x2 = static_cast<int16_t>(data_[14]);
+  int64_t y2 = static_cast<int16_t>(data_[14] >> 16);
+  SetMac0(x0 * y1 + x1 * y2 + x2 * y0 - x0 * y2 - x1 * y0 - x2 * y1);
+}
+
+void MipsPsxGte::Op(bool sf, bool lm) {
+  // Cross product of IR with the rotation matrix diagonal
+  int64_t d1 = matrix_[kRotation][0][0];
+  int64_t d2 = matrix_[kRotation][1][1];
+  int64_t d3 = matrix_[kRotation][2][2];
+  int64_t ir1 = GetIr(1);
+  int64_t ir2 = GetIr(2);
+  int64_t ir3 = GetIr(3);
+  SetMacAndIr(1, ir3 * d2 - ir2 * d3, sf, lm);
+  SetMacAndIr(2, ir1 * d3 - ir3 * d1, sf, lm);
+  SetMacAndIr(3, ir2 * d1 - ir1 * d2, sf, lm);
+}
+
+void MipsPsxGte::Dpcs(uint32_t color, bool sf, bool lm) {
+  int64_t mac[3];
+  for (int i = 0; i < 3; i++) {
+    mac[i] = static_cast<int64_t>((color >> (i * 8)) & 0xFF) << 16;
+  }
+  Interpolate(mac, sf, lm);
+  PushColor();
+}
+
+void MipsPsxGte::Intpl(bool sf, bool lm) {
+  int64_t mac[3];
+  for (int i = 0; i < 3; i++) {
+    mac[i] = static_cast<int64_t>(GetIr(i + 1)) << 12;
+  }
+  Interpolate(mac, sf, lm);
+  PushColor();
+}
+
+void MipsPsxGte::Mvmva(uint32_t command) {
+  bool sf = command & (1 << 19);
+  bool lm = command & (1 << 10);
+  int matrix = (command >> 17) & 3;
+  int vector = (command >> 15) & 3;
+  int translation = (command >> 13) & 3;
+
+  int16_t vx, vy, vz;
+  if (vector == 3) {
+    vx = GetIr(1);
+    vy = GetIr(2);
+    vz = GetIr(3);
+  } else {
+    vx = GetVector(vector, 0);
+    vy = GetVector(vector, 1);
+    vz = GetVector(vector, 2);
+  }
+
+  if (matrix == kGarbage) {
+    // mx = 3 reads a matrix made of R, IR0, RT13 and RT22
+    int32_t red = static_cast<int16_t>((data_[6] & 0xFF) << 4);
+    int32_t rows[3][3] = {
+        {-red, red, GetIr(0)},
+        {matrix_[kRotation][2][0], matrix_[kRotation][2][0], matrix_[kRotation][2][0]},
+        {matrix_[kRotation][1][1], matrix_[kRotation][1][1], matrix_[kRotation][1][1]},
+    };
+    for (int column = 0; column < 3; column++) {
+      for (int row = 0; row < 3; row++) {
+        matrix_[kGarbage][column][row] = rows[row][column];
+      }
+    }
+  }
+
+  if (translation == kFarColor) {
+    TransformFarColorBug(matrix, vx, vy, vz, sf, lm);
+  } else {
+    Transform(matrix, translation, vx, vy, vz, sf, lm);
+  }
+}
+
+void MipsPsxGte::Ncds(int vector, bool sf, bool lm) {
+  Transform(kLight, kNoTranslation, GetVector(vector, 0), GetVector(vector, 1), GetVector(vector, 2), sf, lm);
+  Transform(kLightColor, kBackground, GetIr(1), GetIr(2), GetIr(3), sf, lm);
+  int64_t mac[3];
+  MultiplyColor(mac);
+  Interpolate(mac, sf, lm);
+  PushColor();
+}
+
+void MipsPsxGte::Cdp(bool sf, bool lm) {
+  Transform(kLightColor, kBackground, GetIr(1), GetIr(2), GetIr(3), sf, lm);
+  int64_t mac[3];
+  MultiplyColor(mac);
+  Interpolate(mac, sf, lm);
+  PushColor();
+}
+
+void MipsPsxGte::Nccs(int vector, bool sf, bool lm) {
+  Transform(kLight, kNoTranslation, GetVector(vector, 0), GetVector(vector, 1), GetVector(vector, 2), sf, lm);
+  Transform(kLightColor, kBackground, GetIr(1), GetIr(2), GetIr(3), sf, lm);
+  int64_t mac[3];
+  MultiplyColor(mac);
+  for (int i = 0; i < 3; i++) {
+    SetMacAndIr(i + 1, mac[i], sf, lm);
+  }
+  PushColor();
+}
+
+void MipsPsxGte::Cc(bool sf, bool lm) {
+  Transform(kLightColor, kBackground, GetIr(1), GetIr(2), GetIr(3), sf, lm);
+  int64_t mac[3];
+  MultiplyColor(mac);
+  for (int i = 0; i < 3; i++) {
+    SetMacAndIr(i + 1, mac[i], sf, lm);
+  }
+  PushColor();
+}
+
+void MipsPsxGte::Ncs(int vector, bool sf, bool lm) {
+  Transform(kLight, kNoTranslation, GetVector(vector, 0), GetVector(vector, 1), GetVector(vector, 2), sf, lm);
+  Transform(kLightColor, kBackground, GetIr(1), GetIr(2), GetIr(3), sf, lm);
+  PushColor();
+}
+
+void MipsPsxGte::Sqr(bool sf, bool lm) {
+  for (int i = 1; i <= 3; i++) {
+    int64_t ir = GetIr(i);
+    SetMacAndIr(i, ir * ir, sf, lm);
+  }
+}
+
+void MipsPsxGte::Dcpl(bool sf, bool lm) {
+  int64_t mac[3];
+  MultiplyColor(mac);
+  Interpolate(mac, sf, lm);
+  PushColor();
+}
+
+void MipsPsxGte::Avsz(int16_t scale, int count) {
+  // AVSZ3 averages SZ1-3, AVSZ4 SZ0-3
+  int64_t sum = 0;
+  for (int i = 4 - count; i < 4; i++) {
+    sum += data_[16 + i];
+  }
+  int64_t average = scale * sum;
+  SetMac0(average);
+  int32_t otz = static_cast<int32_t>(average >> 12);
+  if (otz < 0 || otz > 0xFFFF) {
+    flag_ |= kFlagSz;
+    otz = std::clamp(otz, 0, 0xFFFF);
+  }
+  data_[7] = otz;
+}
+
+void MipsPsxGte::Gpf(bool sf, bool lm) {
+  int64_t ir0 = GetIr(0);
+  for (int i = 1; i <= 3; i++) {
+    SetMacAndIr(i, ir0 * GetIr(i), sf, lm);
+  }
+  PushColor();
+}
+
+void MipsPsxGte::Gpl(bool sf, bool lm) {
+  int64_t ir0 = GetIr(0);
+  for (int i = 1; i <= 3; i++) {
+    int64_t mac = static_cast<int64_t>(GetMac(i)) << (sf ? 12 : 0);
+    SetMacAndIr(i, mac + ir0 * GetIr(i), sf, lm);
+  }
+  PushColor();
+}
+
+int32_t MipsPsxGte::Transform(int matrix, int translation, int16_t vx, int16_t vy, int16_t vz, bool sf, bool lm,
+                              bool is_rtp) {
+  alignas(16) int32_t low[4];
+  alignas(16) int32_t high[4];
+  alignas(16) int32_t ir[4];
+  multiply_rows(matrix_[matrix], translation_[translation], vx, vy, vz, low, high);
+  if (!skip_overflow_flags_ && may_overflow_[translation]) {
+    CheckTransformOverflow(matrix, translation, vx, vy, vz);
+  }
+
+  const int32_t* mac = sf ? high : low;
+  uint32_t clamped = saturate_rows(mac, lm, ir);
+  if (is_rtp && !sf) {
+    // RTPS/RTPT with sf = 0 still clamp IR3 to MAC3, but flag it by MAC3 >> 12
+    clamped = (clamped & 3) | (high[2] < -0x8000 || high[2] > 0x7FFF ? 4 : 0);
+  }
+  for (int i = 0; i < 3; i++) {
+    data_[25 + i] = mac[i];
+    data_[9 + i] = ir[i];
+    if (clamped & (1 << i)) {
+      flag_ |= flag_ir(i + 1);
+    }
+  }
+  return high[2];
+}
+
+void MipsPsxGte::TransformFarColorBug(int matrix, int16_t vx, int16_t vy, int16_t vz, bool sf, bool lm) {
+  // Only the first column sees the far color. It sets IR flags, but the
+  // result is the sum of the other two columns alone.
+  const int32_t (*m)[4] = matrix_[matrix];
+  for (int row = 0; row < 3; row++) {
+    int64_t first = (static_cast<int64_t>(translation_[kFarColor][row]) << 12) + static_cast<int64_t>(m[0][row]) * vx;
+    first = CheckMac(row + 1, first);
+    SetIr(row + 1, static_cast<int32_t>(first >> (sf ? 12 : 0)), false);
+  }
+  for (int row = 0; row < 3; row++) {
+    int64_t sum = static_cast<int64_t>(m[1][row]) * vy + static_cast<int64_t>(m[2][row]) * vz;
+    SetMacAndIr(row + 1, sum, sf, lm);
+  }
+}
+
+void MipsPsxGte::CheckTransformOverflow(int matrix, int translation, int16_t vx, int16_t vy, int16_t vz) {
+  // The hardware checks after every addition and carries on with the sum
+  // wrapped to 44 bits
+  const int32_t (*m)[4] = matrix_[matrix];
+  const int32_t* t = translation_[translation];
+  for (int row = 0; row < 3; row++) {
+    int64_t sum = static_cast<int64_t>(t[row]) << 12;
+    sum = CheckMac(row + 1, sum + static_cast<int64_t>(m[0][row]) * vx);
+    sum = CheckMac(row + 1, sum + static_cast<int64_t>(m[1][row]) * vy);
+    CheckMac(row + 1, sum + static_cast<int64_t>(m[2][row]) * vz);
+  }
+}
+
+void MipsPsxGte::MultiplyColor(int64_t* mac) {
+  for (int i = 0; i < 3; i++) {
+    int64_t color = (data_[6] >> (i * 8)) & 0xFF;
+    mac[i] = (color * GetIr(i + 1)) << 4;
+  }
+}
+
+void MipsPsxGte::Interpolate(const int64_t* mac, bool sf, bool lm) {
+  for (int i = 0; i < 3; i++) {
+    int64_t far_color = static_cast<int64_t>(translation_[kFarColor][i]) << 12;
+    SetMacAndIr(i + 1, far_color - mac[i], sf, false);
+  }
+  int64_t ir0 = GetIr(0);
+  for (int i = 0; i < 3; i++) {
+    SetMacAndIr(i + 1, GetIr(i + 1) * ir0 + mac[i], sf, lm);
+  }
+}
+
+int64_t MipsPsxGte::CheckMac(int index, int64_t value) {
+  if (!skip_overflow_flags_) {
+    if (value > kMacMax) {
+      flag_ |= flag_mac_positive(index);
+    } else if (value < kMacMin) {
+      flag_ |= flag_mac_negative(index);
+    }
+  }
+  return sext44(value);
+}
+
+void MipsPsxGte::SetMac(int index, int64_t value, bool sf) {
+  CheckMac(index, value);
+  data_[24 + index] = static_cast<int32_t>(value >> (sf ? 12 : 0));
+}
+
+void MipsPsxGte::SetMacAndIr(int index, int64_t value, bool sf, bool lm) {
+  SetMac(index, value, sf);
+  SetIr(index, GetMac(index), lm);
+}
+
+void MipsPsxGte::SetIr(int index, int32_t value, bool lm) {
+  int32_t clamped = std::clamp(value, lm ? 0 : -0x8000, 0x7FFF);
+  if (clamped != value) {
+    flag_ |= flag_ir(index);
+  }
+  data_[8 + index] = clamped;
+}
+
+void MipsPsxGte::SetMac0(int64_t value) {
+  if (!skip_overflow_flags_) {
+    if (value > INT32_MAX) {
+      flag_ |= kFlagMac0Positive;
+    } else if (value < INT32_MIN) {
+      flag_ |= kFlagMac0Negative;
+    }
+  }
+  data_[24] = static_cast<int32_t>(value);
+}
+
+void MipsPsxGte::SetIr0(int32_t value) {
+  int32_t clamped = std::clamp(value, 0, 0x1000);
+  if (clamped != value) {
+    flag_ |= kFlagIr0;
+  }
+  data_[8] = clamped;
+}
+
+void MipsPsxGte::PushSz(int32_t value) {
+  int32_t clamped = std::clamp(value, 0, 0xFFFF);
+  if (clamped != value) {
+    flag_ |= kFlagSz;
+  }
+  data_[16] = data_[17];
+  data_[17] = data_[18];
+  data_[18] = data_[19];
+  data_[19] = clamped;
+}
+
+void MipsPsxGte::PushSxy(int32_t x, int32_t y) {
+  int32_t clamped_x = std::clamp(x, -0x400, 0x3FF);
+  int32_t clamped_y = std::clamp(y, -0x400, 0x3FF);
+  if (clamped_x != x) {
+    flag_ |= kFlagSx;
+  }
+  if (clamped_y != y) {
+    flag_ |= kFlagSy;
+  }
+  data_[12] = data_[13];
+  data_[13] = data_[14];
+  data_[14] = (static_cast<uint32_t>(clamped_x) & 0xFFFF) | (static_cast<uint32_t>(clamped_y) << 16);
+}
+
+void MipsPsxGte::PushColor() {
+  // The code byte of RGBC passes through unchanged
+  uint32_t rgb = data_[6] & 0xFF000000;
+  for (int i = 0; i < 3; i++) {
+    int32_t value = GetMac(i + 1) >> 4;
+    int32_t clamped = std::clamp(value, 0, 0xFF);
+    if (clamped != value) {
+      flag_ |= flag_color(i + 1);
+    }
+    rgb |= static_cast<uint32_t>(clamped) << (i * 8);
+  }
+  data_[20] = data_[21];
+  data_[21] = data_[22];
+  data_[22] = rgb;
+}
+
+uint32_t MipsPsxGte::Divide() {
+  // H / SZ3 as 1.16 fixed point, by Newton-Raphson on a table seed
+  uint32_t h = static_cast<uint16_t>(control_[26]);
+  uint32_t sz3 = data_[19];
+  if (h >= sz3 * 2) {
+    flag_ |= kFlagDivide;
+    return 0x1FFFF;
+  }
+
+  int shift = std::countl_zero(static_cast<uint16_t>(sz3));
+  uint64_t n = static_cast<uint64_t>(h) << shift;
+  uint32_t d = sz3 << shift;
+  uint32_t u = kUnrTable[(d - 0x7FC0) >> 7] + 0x101;
+  d = (0x2000080 - d * u) >> 8;
+  d = (0x80 + d * u) >> 8;
+  return static_cast<uint32_t>(std::min<uint64_t>(0x1FFFF, (n * d + 0x8000) >> 16));
+}
+
+int16_t MipsPsxGte::GetVector(int vector, int axis) {
+  uint32_t xy = data_[vector * 2];
+  switch (axis) {
+    case 0:
+      return static_cast<int16_t>(xy);
+    case 1:
+      return static_cast<int16_t>(xy >> 16);
+    default:
+      return static_cast<int16_t>(data_[vector * 2 + 1]);
+  }
+}
+
+uint32_t MipsPsxGte::GetOrgb() {
+  uint32_t value = 0;
+  for (int i = 0; i < 3; i++) {
+    value |= static_cast<uint32_t>(std::clamp(GetIr(i + 1) >> 7, 0, 0x1F)) << (i * 5);
+  }
+  return value;
+}
+
+void MipsPsxGte::UpdateUnpacked(int idx) {
+  // Each group is a matrix in five registers and a translation in three
+  if (idx >= 24) {
+    return;
+  }
+  int slot = idx / 8;
+  int base = slot * 8;
+  if (idx - base < 5) {
+    for (int k = 0; k < 9; k++) {
+      uint32_t pair = control_[base + k / 2];
+      int16_t element = static_cast<int16_t>((k & 1) ? pair >> 16 : pair);
+      matrix_[slot][k % 3][k / 3] = element;
+    }
+    return;
+  }
+
+  may_overflow_[slot] = false;
+  for (int row = 0; row < 3; row++) {
+    int32_t value = static_cast<int32_t>(control_[base + 5 + row]);
+    translation_[slot][row] = value;
+    if (value > kSafeTranslation || value < -kSafeTranslation) {
+      may_overflow_[slot] = true;
+    }
+  }
+}
+
+void MipsPsxGte::UpdateAllUnpacked() {
+  std::memset(matrix_, 0, sizeof(matrix_));
+  std::memset(translation_, 0, sizeof(translation_));
+  std::memset(may_overflow_, 0, sizeof(may_overflow_));
+  for (int idx = 0; idx < 24; idx++) {
+    UpdateUnpacked(idx);
+  }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+
+#include "mips_cop.h"
+
+// PSX geometry transformation engine (COP2). Created by MipsBase when
+// MipsConfig::has_psx_gte_ is set. Data registers are idx 0-31 and control
+// registers 32-63, which is how MipsBase addresses them for MFC2/MTC2 and
+// CFC2/CTC2; LWC2/SWC2 use the data registers. Commands run in Command().
+//
+// Results and FLAG follow the hardware bit for bit, including the UNR
+// divider and the MVMVA quirks. Matrix-vector products, the core of
+// RTPS/RTPT, MVMVA and the lighting commands, work on all three rows at
+// once: each product fits in 32 bits, and only the low 32 bits of a sum and
+// its bits 12-43 ever reach a register, so both are computed in 32-bit lanes
+// without widening. The 44-bit MAC overflow flags are the one thing that
+// needs the full sum. It is only rebuilt when a translation vector is large
+// enough to overflow, which is known as soon as it is written.
+//
+// With skip_overflow_flags set, commands do not check MAC0-MAC3 for
+// overflow, so FLAG bits 30-25 and 16-15 stay clear. Results and the
+// saturation flags are unchanged.
+//
+// Lane arithmetic uses SSE4.1 when this file is compiled with it
+// (NGMIPS_PSX_GTE_SSE41) and a portable per-row loop otherwise. Both produce
+// the same results.
+class MipsPsxGte : public MipsCopBase {
+ public:
+  explicit MipsPsxGte(bool skip_overflow_flags = false);
+
+  void ConnectCpu(MipsInterface* cpu) override {}
+  void Reset() override;
+  void Command(uint32_t command) override;
+  uint32_t Read32(int idx) override;
+  void Write32(int idx, uint32_t value) override;
+  uint64_t Read64(int idx) override { return Read32(idx); }
+  void Write64(int idx, uint64_t value) override { Write32(idx, value); }
+  uint32_t Read32Internal(int idx) override { return 0; }
+  void Write32Internal(int idx, uint32_t value) override {}
+  uint64_t Read64Internal(int idx) override { return 0; }
+  void Write64Internal(int idx, uint64_t value) override {}
+  bool GetFlag() override { return false; }
+  void SaveState(MipsStateWriter& writer) override;
+  bool LoadState(MipsStateReader& reader, bool commit) override;
+
+ private:
+  // Matrix slots, in control register order (MVMVA's mx)
+  static const int kRotation = 0;
+  static const int kLight = 1;
+  static const int kLightColor = 2;
+  // MVMVA's mx = 3 matrix, built from other registers when it is used
+  static const int kGarbage = 3;
+  // Translation slots, in control register order (MVMVA's cv)
+  static const int kTranslation = 0;
+  static const int kBackground = 1;
+  static const int kFarColor = 2;
+  static const int kNoTranslation = 3;
+
+  void Rtps(int vector, bool sf, bool lm, bool is_last);
+  void Nclip();
+  void Op(bool sf, bool lm);
+  void Dpcs(uint32_t color, bool sf, bool lm);
+  void Intpl(bool sf, bool lm);
+  void Mvmva(uint32_t command);
+  void Ncds(int vector, bool sf, bool lm);
+  void Cdp(bool sf, bool lm);
+  void Nccs(int vector, bool sf, bool lm);
+  void Cc(bool sf, bool lm);
+  void Ncs(int vector, bool sf, bool lm);
+  void Sqr(bool sf, bool lm);
+  void Dcpl(bool sf, bool lm);
+  void Avsz(int16_t scale, int count);
+  void Gpf(bool sf, bool lm);
+  void Gpl(bool sf, bool lm);
+
+  // MAC1-3 and IR1-3 = (translation * 0x1000 + matrix * v) >> (sf * 12).
+  // Returns MAC3 >> 12 regardless of sf, which RTPS needs for SZ3.
+  int32_t Transform(int matrix, int translation, int16_t vx, int16_t vy, int16_t vz, bool sf, bool lm,
+                    bool is_rtp = false);
+  // MVMVA with the far color as translation, which drops the first column
+  void TransformFarColorBug(int matrix, int16_t vx, int16_t vy, int16_t vz, bool sf, bool lm);
+  // Sets the 44-bit overflow flags of a Transform() that may have overflowed
+  void CheckTransformOverflow(int matrix, int translation, int16_t vx, int16_t vy, int16_t vz);
+  // [MAC1, MAC2, MAC3] = [R * IR1, G * IR2, B * IR3] << 4, before the shift
+  void MultiplyColor(int64_t* mac);
+  // MAC and IR = mac + (FC - mac) * IR0, from MAC before the shift
+  void Interpolate(const int64_t* mac, bool sf, bool lm);
+
+  int64_t CheckMac(int index, int64_t value);
+  void SetMac(int index, int64_t value, bool sf);
+  void SetMacAndIr(int index, int64_t value, bool sf, bool lm);
+  void SetIr(int index, int32_t value, bool lm);
+  void SetMac0(int64_t value);
+  void SetIr0(int32_t value);
+  void PushSz(int32_t value);
+  void PushSxy(int32_t x, int32_t y);
+  void PushColor();
+  uint32_t Divide();
+
+  int16_t GetVector(int vector, int axis);
+  int16_t GetIr(int index) { return static_cast<int16_t>(data_[8 + index]); }
+  int32_t GetMac(int index) { return static_cast<int32_t>(data_[24 + index]); }
+  uint32_t GetOrgb();
+  // Unpacks the matrix or translation held in the given control register
+  void UpdateUnpacked(int idx);
+  void UpdateAllUnpacked();
+
+  bool skip_overflow_flags_;
+
+  uint32_t data_[32];
+  uint32_t control_[32];
+  uint32_t flag_;
+
+  // matrix_[m][column][row]; row 3 is padding
+  alignas(16) int32_t matrix_[4][3][4];
+  alignas(16) int32_t translation_[4][4];
+  // Whether translation * 0x1000 plus three products can leave 44 bits
+  bool may_overflow_[4];
+};
@@ -0,0 +1,166 @@
+#include "mips_rewind.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+// Delta stream: repeated [uint16 zero run][uint16 literal length][literals]
+// over the XOR of two snapshots of the same size.
+
+MipsRewindBuffer::MipsRewindBuffer(MipsInterface* cpu, int capacity, uint64_t interval) {
+  cpu_ = cpu;
+  capacity_ = std::max(capacity, 1);
+  interval_ = std::max<uint64_t>(interval, 1);
+  Reset();
+}
+
+void MipsRewindBuffer::Reset() {
+  next_capture_ = 0;
+  has_latest_ = false;
+  latest_timestamp_ = 0;
+  latest_.clear();
+  deltas_.clear();
+}
+
+int MipsRewindBuffer::Run(int cycle) {
+  int spent = 0;
+  while (spent < cycle) {
+    uint64_t timestamp = cpu_->GetTimestamp();
+    if (timestamp >= next_capture_) {
+      Capture();
+    }
+    uint64_t until_capture = next_capture_ - cpu_->GetTimestamp();
+    int slice = std::min<uint64_t>(cycle - spent, until_capture);
+    spent += cpu_->Run(slice);
+  }
+  return spent;
+}
+
+void MipsRewindBuffer::Capture() {
+  uint64_t timestamp = cpu_->GetTimestamp();
+  cpu_->SaveState(scratch_);
+  next_capture_ = timestamp + interval_;
+
+  if (has_latest_ && latest_.size() == scratch_.size()) {
+    if (deltas_.size() + 1 >= static_cast<size_t>(capacity_)) {
+      // Reuse the oldest entry's storage for the new delta
+      Delta recycled = std::move(deltas_.front());
+      deltas_.pop_front();
+      deltas_.push_back(std::move(recycled));
+    } else {
+      deltas_.emplace_back();
+    }
+    Delta& delta = deltas_.back();
+    delta.timestamp_ = latest_timestamp_;
+    EncodeDelta(latest_, scratch_, delta.data_);
+  } else {
+    // First capture, or the snapshot layout changed: start a new chain
+    deltas_.clear();
+  }
+
+  std::swap(latest_, scratch_);
+  latest_timestamp_ = timestamp;
+  has_latest_ = true;
+}
+
+bool MipsRewindBuffer::RunTo(uint64_t timestamp) {
+  if (cpu_->GetTimestamp() > timestamp) {
+    if (!has_latest_ || GetOldestTimestamp() > timestamp) {
+      return false;
+    }
+
+    // Walk back from the newest snapshot until one is at or before timestamp
+    while (latest_timestamp_ > timestamp) {
+      Delta& delta = deltas_.back();
+      if (!ApplyDelta(delta.data_, latest_)) {
+        fmt::print("Rewind buffer is corrupted\n");
+        Reset();
+        return false;
+      }
+      latest_timestamp_ = delta.timestamp_;
+      deltas_.pop_back();
+    }
+
+    if (!cpu_->LoadState(latest_)) {
+      Reset();
+      return false;
+    }
+    next_capture_ = latest_timestamp_ + interval_;
+  }
+
+  while (cpu_->GetTimestamp() < timestamp) {
+    uint64_t remaining = timestamp - cpu_->GetTimestamp();
+    Run(std::min<uint64_t>(remaining, INT_MAX));
+  }
+  return true;
+}
+
+uint64_t MipsRewindBuffer::GetOldestTimestamp() const {
+  if (!deltas_.empty()) {
+    return deltas_.front().timestamp_;
+  }
+  return latest_timestamp_;
+}
+
+size_t MipsRewindBuffer::GetMemoryUsage() const {
+  size_t usage = latest_.capacity() + scratch_.capacity();
+  for (const Delta& delta : deltas_) {
+    usage += sizeof(Delta) + delta.data_.capacity();
+  }
+  return usage;
+}
+
+void MipsRewindBuffer::EncodeDelta(const std::vector<uint8_t>& older, const std::vector<uint8_t>& newer,
+                                   std::vector<uint8_t>& out) {
+  out.clear();
+  const size_t size = older.size();
+  size_t i = 0;
+  while (i < size) {
+    uint16_t zero_run = 0;
+    while (i < size && zero_run < UINT16_MAX && older[i] == newer[i]) {
+      zero_run++;
+      i++;
+    }
+    size_t literal_start = i;
+    uint16_t literal_length = 0;
+    while (i < size && literal_length < UINT16_MAX && older[i] != newer[i]) {
+      literal_length++;
+      i++;
+    }
+
+    size_t offset = out.size();
+    out.resize(offset + 4 + literal_length);
+    std::memcpy(&out[offset], &zero_run, 2);
+    std::memcpy(&out[offset + 2], &literal_length, 2);
+    for (int j = 0; j < literal_length; j++) {
+      out[offset + 4 + j] = older[literal_start + j] ^ newer[literal_start + j];
+    }
+  }
+}
+
+bool MipsRewindBuffer::ApplyDelta(const std::vector<uint8_t>& delta, std::vector<uint8_t>& state) {
+  size_t position = 0;
+  size_t offset = 0;
+  while (offset < delta.size()) {
+    if (delta.size() - offset < 4) {
+      return false;
+    }
+    uint16_t zero_run;
+    uint16_t literal_length;
+    std::memcpy(&zero_run, &delta[offset], 2);
+    std::memcpy(&literal_length, &delta[offset + 2], 2);
+    offset += 4;
+    position += zero_run;
+    if (position + literal_length > state.size() || offset + literal_length > delta.size()) {
+      return false;
+    }
+    for (int j = 0; j < literal_length; j++) {
+      state[position + j] ^= delta[offset + j];
+    }
+    position += literal_length;
+    offset += literal_length;
+  }
+  return position == state.size();
+}
@@ -0,0 +1,1551 @@
+#include "mips_rsp_vu.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+#include "bus_base.h"
+#include "mips_base.h"
+#include "mips_state.h"
+#include "panic.h"
+
+namespace {
+
+// Vector loads and stores see DMEM through a 12-bit address
+const uint32_t kDmemMask = 0xFFF;
+
+class VuInst {
+ private:
+  uint32_t raw_;
+
+ public:
+  VuInst(uint32_t opcode) {
+    raw_ = opcode;
+  }
+
+  // Computational ops
+  uint8_t funct() { return raw_ & 0b111111; };
+  uint8_t vd() { return (raw_ >> 6) & 0b11111; };
+  uint8_t vs() { return (raw_ >> 11) & 0b11111; };
+  uint8_t vt() { return (raw_ >> 16) & 0b11111; };
+  uint8_t e() { return (raw_ >> 21) & 0b1111; };
+
+  // LWC2/SWC2; vt() is shared
+  int32_t offset() { return static_cast<int32_t>(raw_ << 25) >> 25; };
+  uint8_t element() { return (raw_ >> 7) & 0b1111; };
+  uint8_t kind() { return (raw_ >> 11) & 0b11111; };
+  uint8_t base() { return (raw_ >> 21) & 0b11111; };
+};
+
+// Lane of vt that lane `lane` reads for element selector e: 0-1 whole
+// vector, 2-3 pairs (0q/1q), 4-7 quarters (0h-3h), 8-15 one element
+constexpr int element_index(int e, int lane) {
+  if (e < 2) {
+    return lane;
+  } else if (e < 4) {
+    return (lane & 6) | (e & 1);
+  } else if (e < 8) {
+    return (lane & 4) | (e & 3);
+  }
+  return e & 7;
+}
+
+struct ElementTable {
+  uint8_t index_[16][8];
+  alignas(16) uint8_t shuffle_[16][16];
+};
+
+constexpr ElementTable make_element_table() {
+  ElementTable table{};
+  for (int e = 0; e < 16; e++) {
+    for (int lane = 0; lane < 8; lane++) {
+      int index = element_index(e, lane);
+      table.index_[e][lane] = index;
+      table.shuffle_[e][lane * 2] = index * 2;
+      table.shuffle_[e][lane * 2 + 1] = index * 2 + 1;
+    }
+  }
+  return table;
+}
+
+constexpr ElementTable kElementTable = make_element_table();
+
+// VRCP/VRSQ mantissa tables, generated the same way as the RSP's ROM
+struct DivideTable {
+  uint16_t reciprocal_[512];
+  uint16_t inverse_sqrt_[512];
+
+  DivideTable() {
+    for (int i = 0; i < 512; i++) {
+      uint64_t a = i + 512;
+      uint64_t b = (1ULL << 34) / a;
+      reciprocal_[i] = std::min<uint64_t>((b + 1) >> 8, 0x1FFFF);
+    }
+    for (int i = 0; i < 512; i++) {
+      // Largest b with a * b^2 < 2^44
+      uint64_t a = (i + 512) >> (i & 1);
+      uint64_t b = static_cast<uint64_t>(std::sqrt(static_cast<double>(1ULL << 44) / a));
+      while (a * b * b >= (1ULL << 44)) {
+        b--;
+      }
+      while (a * (b + 1) * (b + 1) < (1ULL << 44)) {
+        b++;
+      }
+      inverse_sqrt_[i] = b >> 1;
+    }
+  }
+};
+
+const DivideTable& get_divide_table() {
+  static const DivideTable table;
+  return table;
+}
+
+int16_t clamp_s16(int64_t value) {
+  return static_cast<int16_t>(std::clamp<int64_t>(value, INT16_MIN, INT16_MAX));
+}
+
+uint16_t mask_of(bool value) {
+  return value ? 0xFFFF : 0x0000;
+}
+
+uint32_t pack_mask(const uint16_t* lanes) {
+  uint32_t value = 0;
+  for (int lane = 0; lane < 8; lane++) {
+    value |= (lanes[lane] & 1) << lane;
+  }
+  return value;
+}
+
+void unpack_mask(uint16_t* lanes, uint32_t value) {
+  for (int lane = 0; lane < 8; lane++) {
+    lanes[lane] = mask_of(value & (1 << lane));
+  }
+}
+
+#if defined(__SSE4_1__)
+
+__m128i load_lanes(const uint16_t* lanes) {
+  return _mm_load_si128(reinterpret_cast<const __m128i*>(lanes));
+}
+
+void store_lanes(uint16_t* lanes, __m128i value) {
+  _mm_store_si128(reinterpret_cast<__m128i*>(lanes), value);
+}
+
+__m128i select_element(const uint16_t* lanes, int e) {
+  __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(kElementTable.shuffle_[e]));
+  return _mm_shuffle_epi8(load_lanes(lanes), shuffle);
+}
+
+// Shuffle indices in DMEM byte order. Host lane i holds element i with its
+// high byte at host byte 2i + 1, so register byte j is host byte j ^ 1.
+__m128i byte_index() {
+  return _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+}
+
+__m128i swapped_byte_index() {
+  return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+}
+
+// Picks register bytes (i + rotation) & 15 out of host lanes
+__m128i rotated_byte_index(int rotation) {
+  __m128i index = _mm_and_si128(_mm_add_epi8(byte_index(), _mm_set1_epi8(rotation)), _mm_set1_epi8(15));
+  return _mm_xor_si128(index, _mm_set1_epi8(1));
+}
+
+__m128i all_ones() {
+  return _mm_set1_epi16(-1);
+}
+
+// 0xFFFF where a < b as unsigned
+__m128i cmplt_epu16(__m128i a, __m128i b) {
+  __m128i bias = _mm_set1_epi16(-0x8000);
+  return _mm_cmplt_epi16(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+}
+
+// 48-bit accumulator += (ph:pm:pl), carrying between the 16-bit slices
+void add_acc(__m128i& h, __m128i& m, __m128i& l, __m128i ph, __m128i pm, __m128i pl) {
+  __m128i sum_l = _mm_add_epi16(l, pl);
+  __m128i carry_l = cmplt_epu16(sum_l, l);
+  __m128i sum_m = _mm_add_epi16(m, pm);
+  __m128i carry_m = cmplt_epu16(sum_m, m);
+  carry_m = _mm_or_si128(carry_m, _mm_and_si128(carry_l, _mm_cmpeq_epi16(sum_m, all_ones())));
+  l = sum_l;
+  m = _mm_sub_epi16(sum_m, carry_l);
+  h = _mm_sub_epi16(_mm_add_epi16(h, ph), carry_m);
+}
+
+#else
+
+void select_element(uint16_t* out, const uint16_t* lanes, int e) {
+  for (int lane = 0; lane < 8; lane++) {
+    out[lane] = lanes[kElementTable.index_[e][lane]];
+  }
+}
+
+#endif
+
+}  // namespace
+
+MipsRspVu::MipsRspVu() {
+#if defined(__SSE4_1__) && (defined(__GNUC__) || defined(__clang__))
+  if (!__builtin_cpu_supports("sse4.1")) {
+    PANIC("RSP vector unit was built with SSE4.1 but the host does not support it");
+  }
+#endif
+  Reset();
+}
+
+void MipsRspVu::ConnectCpu(MipsInterface* cpu) {
+  cpu_ = cpu;
+}
+
+void MipsRspVu::ConnectBus(BusBase* bus) {
+  bus_ = bus;
+  dmem_ = bus != nullptr ? bus->GetDmemPointer() : nullptr;
+}
+
+void MipsRspVu::Reset() {
+  std::memset(vr_, 0, sizeof(vr_));
+  std::memset(acc_h_, 0, sizeof(acc_h_));
+  std::memset(acc_m_, 0, sizeof(acc_m_));
+  std::memset(acc_l_, 0, sizeof(acc_l_));
+  std::memset(vco_lo_, 0, sizeof(vco_lo_));
+  std::memset(vco_hi_, 0, sizeof(vco_hi_));
+  std::memset(vcc_lo_, 0, sizeof(vcc_lo_));
+  std::memset(vcc_hi_, 0, sizeof(vcc_hi_));
+  std::memset(vce_, 0, sizeof(vce_));
+  div_in_ = 0;
+  div_out_ = 0;
+  div_dp_ = false;
+}
+
+void MipsRspVu::Command(uint32_t command) {
+  VuInst inst(command);
+  switch (command >> 26) {
+    case 0x12:
+      if (command & (1 << 25)) {
+        (this->*GetComputeHandler(command))(command);
+        return;
+      }
+      switch ((command >> 21) & 0x1F) {
+        case 0x00:  // MFC2
+          cpu_->SetGpr(inst.vt(), static_cast<int32_t>(ReadElement(inst.vs(), inst.element())));
+          break;
+        case 0x02:  // CFC2
+          cpu_->SetGpr(inst.vt(), static_cast<int32_t>(ReadControl(inst.vs())));
+          break;
+        case 0x04:  // MTC2
+          WriteElement(inst.vs(), inst.element(), cpu_->GetGpr(inst.vt()));
+          break;
+        case 0x06:  // CTC2
+          WriteControl(inst.vs(), cpu_->GetGpr(inst.vt()));
+          break;
+        default:
+          fmt::print("Unknown RSP COP2 instruction: {:08X}\n", command);
+          break;
+      }
+      break;
+    case 0x32:
+      (this->*GetLoadHandler(command))(command, cpu_->GetGpr(inst.base()));
+      break;
+    case 0x3A:
+      (this->*GetStoreHandler(command))(command, cpu_->GetGpr(inst.base()));
+      break;
+    default:
+      fmt::print("Unknown RSP COP2 instruction: {:08X}\n", command);
+      break;
+  }
+}
+
+uint32_t MipsRspVu::Read32(int idx) {
+  if (idx < 32) {
+    return ReadElement(idx, 0);
+  }
+  return ReadControl(idx - 32);
+}
+
+void MipsRspVu::Write32(int idx, uint32_t value) {
+  if (idx < 32) {
+    WriteElement(idx, 0, value);
+  } else {
+    WriteControl(idx - 32, value);
+  }
+}
+
+void MipsRspVu::SaveState(MipsStateWriter& writer) {
+  writer.Write(vr_);
+  writer.Write(acc_h_);
+  writer.Write(acc_m_);
+  writer.Write(acc_l_);
+  writer.Write(vco_lo_);
+  writer.Write(vco_hi_);
+  writer.Write(vcc_lo_);
+  writer.Write(vcc_hi_);
+  writer.Write(vce_);
+  writer.Write(div_in_);
+  writer.Write(div_out_);
+  writer.Write(div_dp_);
+}
+
+bool MipsRspVu::LoadState(MipsStateReader& reader, bool commit) {
+  uint16_t vr[32][8];
+  uint16_t acc_h[8];
+  uint16_t acc_m[8];
+  uint16_t acc_l[8];
+  uint16_t vco_lo[8];
+  uint16_t vco_hi[8];
+  uint16_t vcc_lo[8];
+  uint16_t vcc_hi[8];
+  uint16_t vce[8];
+  int16_t div_in = 0;
+  int16_t div_out = 0;
+  uint8_t div_dp = 0;
+  reader.Read(vr);
+  reader.Read(acc_h);
+  reader.Read(acc_m);
+  reader.Read(acc_l);
+  reader.Read(vco_lo);
+  reader.Read(vco_hi);
+  reader.Read(vcc_lo);
+  reader.Read(vcc_hi);
+  reader.Read(vce);
+  reader.Read(div_in);
+  reader.Read(div_out);
+  reader.Read(div_dp);
+  if (!reader.IsGood()) {
+    return false;
+  }
+
+  if (commit) {
+    std::memcpy(vr_, vr, sizeof(vr_));
+    std::memcpy(acc_h_, acc_h, sizeof(acc_h_));
+    std::memcpy(acc_m_, acc_m, sizeof(acc_m_));
+    std::memcpy(acc_l_, acc_l, sizeof(acc_l_));
+    std::memcpy(vco_lo_, vco_lo, sizeof(vco_lo_));
+    std::memcpy(vco_hi_, vco_hi, sizeof(vco_hi_));
+    std::memcpy(vcc_lo_, vcc_lo, sizeof(vcc_lo_));
+    std::memcpy(vcc_hi_, vcc_hi, sizeof(vcc_hi_));
+    std::memcpy(vce_, vce, sizeof(vce_));
+    div_in_ = div_in;
+    div_out_ = div_out;
+    div_dp_ = div_dp != 0;
+  }
+  return true;
+}
+
+namespace {
+
+const MipsRspVu::Handler kComputeHandlers[64] = {
+    &MipsRspVu::InstVmulf, &MipsRspVu::InstVmulu, &MipsRspVu::InstVrndp, &MipsRspVu::InstVmulq,
+    &MipsRspVu::InstVmudl, &MipsRspVu::InstVmudm, &MipsRspVu::InstVmudn, &MipsRspVu::InstVmudh,
+    &MipsRspVu::InstVmacf, &MipsRspVu::InstVmacu, &MipsRspVu::InstVrndn, &MipsRspVu::InstVmacq,
+    &MipsRspVu::InstVmadl, &MipsRspVu::InstVmadm, &MipsRspVu::InstVmadn, &MipsRspVu::InstVmadh,
+    &MipsRspVu::InstVadd,  &MipsRspVu::InstVsub,  &MipsRspVu::InstVzero, &MipsRspVu::InstVabs,
+    &MipsRspVu::InstVaddc, &MipsRspVu::InstVsubc, &MipsRspVu::InstVzero, &MipsRspVu::InstVzero,
+    &MipsRspVu::InstVzero, &MipsRspVu::InstVzero, &MipsRspVu::InstVzero, &MipsRspVu::InstVzero,
+    &MipsRspVu::InstVzero, &MipsRspVu::InstVsar,  &MipsRspVu::InstVzero, &MipsRspVu::InstVzero,
+    &MipsRspVu::InstVlt,   &MipsRspVu::InstVeq,   &MipsRspVu::InstVne,   &MipsRspVu::InstVge,
+    &MipsRspVu::InstVcl,   &MipsRspVu::InstVch,   &MipsRspVu::InstVcr,   &MipsRspVu::InstVmrg,
+    &MipsRspVu::InstVand,  &MipsRspVu::InstVnand, &MipsRspVu::InstVor,   &MipsRspVu::InstVnor,
+    &MipsRspVu::InstVxor,  &MipsRspVu::InstVnxor, &MipsRspVu::InstVzero, &MipsRspVu::InstVzero,
+    &MipsRspVu::InstVrcp,  &MipsRspVu::InstVrcpl, &MipsRspVu::InstVrcph, &MipsRspVu::InstVmov,
+    &MipsRspVu::InstVrsq,  &MipsRspVu::InstVrsql, &MipsRspVu::InstVrsqh, &MipsRspVu::InstVnop,
+    &MipsRspVu::InstVzero, &MipsRspVu::InstVzero, &MipsRspVu::InstVzero, &MipsRspVu::InstVzero,
+    &MipsRspVu::InstVzero, &MipsRspVu::InstVzero, &MipsRspVu::InstVzero, &MipsRspVu::InstVnop,
+};
+
+// Indexed by the rd field; 10 (LWV/SWV on some docs) and above are reserved
+// for loads
+const MipsRspVu::MemoryHandler kLoadHandlers[12] = {
+    &MipsRspVu::InstLbv, &MipsRspVu::InstLsv, &MipsRspVu::InstLlv, &MipsRspVu::InstLdv,
+    &MipsRspVu::InstLqv, &MipsRspVu::InstLrv, &MipsRspVu::InstLpv, &MipsRspVu::InstLuv,
+    &MipsRspVu::InstLhv, &MipsRspVu::InstLfv, &MipsRspVu::InstMemoryNop, &MipsRspVu::InstLtv,
+};
+
+const MipsRspVu::MemoryHandler kStoreHandlers[12] = {
+    &MipsRspVu::InstSbv, &MipsRspVu::InstSsv, &MipsRspVu::InstSlv, &MipsRspVu::InstSdv,
+    &MipsRspVu::InstSqv, &MipsRspVu::InstSrv, &MipsRspVu::InstSpv, &MipsRspVu::InstSuv,
+    &MipsRspVu::InstShv, &MipsRspVu::InstSfv, &MipsRspVu::InstSwv, &MipsRspVu::InstStv,
+};
+
+}  // namespace
+
+auto MipsRspVu::GetComputeHandler(uint32_t opcode) -> Handler {
+  return kComputeHandlers[opcode & 0x3F];
+}
+
+auto MipsRspVu::GetLoadHandler(uint32_t opcode) -> MemoryHandler {
+  uint8_t kind = VuInst(opcode).kind();
+  return kind < 12 ? kLoadHandlers[kind] : &MipsRspVu::InstMemoryNop;
+}
+
+auto MipsRspVu::GetStoreHandler(uint32_t opcode) -> MemoryHandler {
+  uint8_t kind = VuInst(opcode).kind();
+  return kind < 12 ? kStoreHandlers[kind] : &MipsRspVu::InstMemoryNop;
+}
+
+uint32_t MipsRspVu::ReadElement(int vs, int element) {
+  uint16_t value = (GetByte(vs, element) << 8) | GetByte(vs, (element + 1) & 15);
+  return static_cast<int16_t>(value);
+}
+
+void MipsRspVu::WriteElement(int vs, int element, uint32_t value) {
+  SetByte(vs, element, value >> 8);
+  if (element != 15) {
+    SetByte(vs, element + 1, value);
+  }
+}
+
+uint32_t MipsRspVu::ReadControl(int idx) {
+  switch (idx & 3) {
+    case 0:
+      return static_cast<int16_t>(pack_mask(vco_lo_) | (pack_mask(vco_hi_) << 8));
+    case 1:
+      return static_cast<int16_t>(pack_mask(vcc_lo_) | (pack_mask(vcc_hi_) << 8));
+    default:
+      return pack_mask(vce_);
+  }
+}
+
+void MipsRspVu::WriteControl(int idx, uint32_t value) {
+  switch (idx & 3) {
+    case 0:
+      unpack_mask(vco_lo_, value);
+      unpack_mask(vco_hi_, value >> 8);
+      break;
+    case 1:
+      unpack_mask(vcc_lo_, value);
+      unpack_mask(vcc_hi_, value >> 8);
+      break;
+    default:
+      unpack_mask(vce_, value);
+      break;
+  }
+}
+
+int64_t MipsRspVu::GetAcc(int lane) {
+  uint64_t value = (static_cast<uint64_t>(acc_h_[lane]) << 32) |
+                   (static_cast<uint64_t>(acc_m_[lane]) << 16) | acc_l_[lane];
+  return static_cast<int64_t>(value << 16) >> 16;
+}
+
+void MipsRspVu::SetAcc(int lane, int64_t value) {
+  acc_h_[lane] = value >> 32;
+  acc_m_[lane] = value >> 16;
+  acc_l_[lane] = value;
+}
+
+uint8_t MipsRspVu::GetByte(int vt, int index) {
+  uint16_t value = vr_[vt][index >> 1];
+  return (index & 1) ? value : value >> 8;
+}
+
+void MipsRspVu::SetByte(int vt, int index, uint8_t value) {
+  uint16_t& lane = vr_[vt][index >> 1];
+  if (index & 1) {
+    lane = (lane & 0xFF00) | value;
+  } else {
+    lane = (lane & 0x00FF) | (value << 8);
+  }
+}
+
+uint8_t MipsRspVu::ReadDmem(uint32_t address) {
+  address &= kDmemMask;
+  if (dmem_ != nullptr) {
+    return dmem_[address];
+  }
+  return bus_->Load8(address).value;
+}
+
+void MipsRspVu::WriteDmem(uint32_t address, uint8_t value) {
+  address &= kDmemMask;
+  if (dmem_ != nullptr) {
+    dmem_[address] = value;
+    return;
+  }
+  bus_->Store8(address, value);
+}
+
+template <MipsRspVu::Product kProduct, MipsRspVu::Clamp kClamp, bool kAccumulate>
+void MipsRspVu::Multiply(uint32_t opcode) {
+  VuInst inst(opcode);
+#if defined(__SSE4_1__)
+  __m128i zero = _mm_setzero_si128();
+  __m128i s = load_lanes(vr_[inst.vs()]);
+  __m128i t = select_element(vr_[inst.vt()], inst.e());
+  __m128i lo = _mm_mullo_epi16(s, t);
+  __m128i ph, pm, pl;
+  if constexpr (kProduct == Product::kFrac) {
+    __m128i hi = _mm_mulhi_epi16(s, t);
+    pl = _mm_slli_epi16(lo, 1);
+    pm = _mm_or_si128(_mm_slli_epi16(hi, 1), _mm_srli_epi16(lo, 15));
+    ph = _mm_srai_epi16(hi, 15);
+  } else if constexpr (kProduct == Product::kLow) {
+    pl = _mm_mulhi_epu16(s, t);
+    pm = zero;
+    ph = zero;
+  } else if constexpr (kProduct == Product::kMid) {
+    // Signed vs times unsigned vt: correct the unsigned high half
+    pl = lo;
+    pm = _mm_sub_epi16(_mm_mulhi_epu16(s, t), _mm_and_si128(t, _mm_srai_epi16(s, 15)));
+    ph = _mm_srai_epi16(pm, 15);
+  } else if constexpr (kProduct == Product::kMidN) {
+    pl = lo;
+    pm = _mm_sub_epi16(_mm_mulhi_epu16(s, t), _mm_and_si128(s, _mm_srai_epi16(t, 15)));
+    ph = _mm_srai_epi16(pm, 15);
+  } else {
+    pl = zero;
+    pm = lo;
+    ph = _mm_mulhi_epi16(s, t);
+  }
+
+  __m128i h, m, l;
+  if constexpr (kAccumulate) {
+    h = load_lanes(acc_h_);
+    m = load_lanes(acc_m_);
+    l = load_lanes(acc_l_);
+    add_acc(h, m, l, ph, pm, pl);
+  } else {
+    h = ph;
+    m = pm;
+    l = pl;
+    if constexpr (kProduct == Product::kFrac) {
+      add_acc(h, m, l, zero, zero, _mm_set1_epi16(-0x8000));
+    }
+  }
+  store_lanes(acc_h_, h);
+  store_lanes(acc_m_, m);
+  store_lanes(acc_l_, l);
+
+  __m128i result;
+  if constexpr (kClamp == Clamp::kSignedMid) {
+    result = _mm_packs_epi32(_mm_unpacklo_epi16(m, h), _mm_unpackhi_epi16(m, h));
+  } else if constexpr (kClamp == Clamp::kUnsignedMid) {
+    __m128i negative = _mm_srai_epi16(h, 15);
+    __m128i fits = _mm_and_si128(_mm_cmpeq_epi16(h, zero), _mm_cmpeq_epi16(_mm_srai_epi16(m, 15), zero));
+    result = _mm_andnot_si128(negative, _mm_blendv_epi8(all_ones(), m, fits));
+  } else {
+    __m128i high_sign = _mm_srai_epi16(h, 15);
+    __m128i fits = _mm_cmpeq_epi16(h, _mm_srai_epi16(m, 15));
+    result = _mm_blendv_epi8(_mm_xor_si128(high_sign, all_ones()), l, fits);
+  }
+  store_lanes(vr_[inst.vd()], result);
+#else
+  uint16_t vt[8];
+  select_element(vt, vr_[inst.vt()], inst.e());
+  const uint16_t* vs = vr_[inst.vs()];
+  uint16_t result[8];
+  for (int lane = 0; lane < 8; lane++) {
+    int16_t s = vs[lane];
+    int16_t t = vt[lane];
+    int64_t product;
+    if constexpr (kProduct == Product::kFrac) {
+      product = static_cast<int64_t>(s) * t * 2;
+    } else if constexpr (kProduct == Product::kLow) {
+      product = (static_cast<uint32_t>(vs[lane]) * vt[lane]) >> 16;
+    } else if constexpr (kProduct == Product::kMid) {
+      product = static_cast<int64_t>(s) * vt[lane];
+    } else if constexpr (kProduct == Product::kMidN) {
+      product = static_cast<int64_t>(vs[lane]) * t;
+    } else {
+      product = static_cast<int64_t>(s) * t * 65536;
+    }
+
+    int64_t acc = kAccumulate ? GetAcc(lane) + product : product;
+    if (kProduct == Product::kFrac && !kAccumulate) {
+      acc += 0x8000;
+    }
+    SetAcc(lane, acc);
+    acc = GetAcc(lane);
+
+    int64_t mid = acc >> 16;
+    if constexpr (kClamp == Clamp::kSignedMid) {
+      result[lane] = clamp_s16(mid);
+    } else if constexpr (kClamp == Clamp::kUnsignedMid) {
+      result[lane] = mid < 0 ? 0x0000 : mid > INT16_MAX ? 0xFFFF : mid;
+    } else {
+      result[lane] = mid < INT16_MIN ? 0x0000 : mid > INT16_MAX ? 0xFFFF : acc_l_[lane];
+    }
+  }
+  std::memcpy(vr_[inst.vd()], result, sizeof(result));
+#endif
+}
+
+void MipsRspVu::InstVmulf(uint32_t opcode) {
+  Multiply<Product::kFrac, Clamp::kSignedMid, false>(opcode);
+}
+
+void MipsRspVu::InstVmulu(uint32_t opcode) {
+  Multiply<Product::kFrac, Clamp::kUnsignedMid, false>(opcode);
+}
+
+void MipsRspVu::InstVmudl(uint32_t opcode) {
+  Multiply<Product::kLow, Clamp::kLow, false>(opcode);
+}
+
+void MipsRspVu::InstVmudm(uint32_t opcode) {
+  Multiply<Product::kMid, Clamp::kSignedMid, false>(opcode);
+}
+
+void MipsRspVu::InstVmudn(uint32_t opcode) {
+  Multiply<Product::kMidN, Clamp::kLow, false>(opcode);
+}
+
+void MipsRspVu::InstVmudh(uint32_t opcode) {
+  Multiply<Product::kHigh, Clamp::kSignedMid, false>(opcode);
+}
+
+void MipsRspVu::InstVmacf(uint32_t opcode) {
+  Multiply<Product::kFrac, Clamp::kSignedMid, true>(opcode);
+}
+
+void MipsRspVu::InstVmacu(uint32_t opcode) {
+  Multiply<Product::kFrac, Clamp::kUnsignedMid, true>(opcode);
+}
+
+void MipsRspVu::InstVmadl(uint32_t opcode) {
+  Multiply<Product::kLow, Clamp::kLow, true>(opcode);
+}
+
+void MipsRspVu::InstVmadm(uint32_t opcode) {
+  Multiply<Product::kMid, Clamp::kSignedMid, true>(opcode);
+}
+
+void MipsRspVu::InstVmadn(uint32_t opcode) {
+  Multiply<Product::kMidN, Clamp::kLow, true>(opcode);
+}
+
+void MipsRspVu::InstVmadh(uint32_t opcode) {
+  Multiply<Product::kHigh, Clamp::kSignedMid, true>(opcode);
+}
+
+// VRNDP/VRNDN, VMULQ and VMACQ are rare in shipped microcode and stay scalar
+void MipsRspVu::Round(uint32_t opcode, bool is_negative) {
+  VuInst inst(opcode);
+  uint16_t vt[8];
+  for (int lane = 0; lane < 8; lane++) {
+    vt[lane] = vr_[inst.vt()][kElementTable.index_[inst.e()][lane]];
+  }
+  for (int lane = 0; lane < 8; lane++) {
+    int64_t product = static_cast<int16_t>(vt[lane]);
+    if (inst.vs() & 1) {
+      product *= 65536;
+    }
+    int64_t acc = GetAcc(lane);
+    if ((acc < 0) == is_negative) {
+      SetAcc(lane, acc + product);
+      acc = GetAcc(lane);
+    }
+    vr_[inst.vd()][lane] = clamp_s16(acc >> 16);
+  }
+}
+
+void MipsRspVu::InstVrndp(uint32_t opcode) {
+  Round(opcode, false);
+}
+
+void MipsRspVu::InstVrndn(uint32_t opcode) {
+  Round(opcode, true);
+}
+
+void MipsRspVu::InstVmulq(uint32_t opcode) {
+  VuInst inst(opcode);
+  uint16_t result[8];
+  for (int lane = 0; lane < 8; lane++) {
+    int16_t s = vr_[inst.vs()][lane];
+    int16_t t = vr_[inst.vt()][kElementTable.index_[inst.e()][lane]];
+    int32_t product = s * t;
+    if (product < 0) {
+      product += 31;
+    }
+    SetAcc(lane, static_cast<int64_t>(product) * 65536);
+    result[lane] = clamp_s16(product >> 1) & ~15;
+  }
+  std::memcpy(vr_[inst.vd()], result, sizeof(result));
+}
+
+void MipsRspVu::InstVmacq(uint32_t opcode) {
+  VuInst inst(opcode);
+  for (int lane = 0; lane < 8; lane++) {
+    int32_t product = static_cast<int32_t>((acc_h_[lane] << 16) | acc_m_[lane]);
+    if (!(product & (1 << 5))) {
+      if (product < 0) {
+        product += 32;
+      } else if (product >= 32) {
+        product -= 32;
+      }
+    }
+    acc_h_[lane] = product >> 16;
+    acc_m_[lane] = product;
+    vr_[inst.vd()][lane] = clamp_s16(product >> 1) & ~15;
+  }
+}
+
+void MipsRspVu::InstVadd(uint32_t opcode) {
+  VuInst inst(opcode);
+#if defined(__SSE4_1__)
+  __m128i s = load_lanes(vr_[inst.vs()]);
+  __m128i t = select_element(vr_[inst.vt()], inst.e());
+  __m128i carry = load_lanes(vco_lo_);
+  store_lanes(acc_l_, _mm_sub_epi16(_mm_add_epi16(s, t), carry));
+  // Saturate s + t + carry: the carry can only push the smaller operand up
+  __m128i low = _mm_subs_epi16(_mm_min_epi16(s, t), carry);
+  store_lanes(vr_[inst.vd()], _mm_adds_epi16(low, _mm_max_epi16(s, t)));
+  store_lanes(vco_lo_, _mm_setzero_si128());
+  store_lanes(vco_hi_, _mm_setzero_si128());
+#else
+  uint16_t vt[8];
+  select_element(vt, vr_[inst.vt()], inst.e());
+  const uint16_t* vs = vr_[inst.vs()];
+  uint16_t* vd = vr_[inst.vd()];
+  for (int lane = 0; lane < 8; lane++) {
+    int32_t sum = static_cast<int16_t>(vs[lane]) + static_cast<int16_t>(vt[lane]) + (vco_lo_[lane] & 1);
+    acc_l_[lane] = sum;
+    vd[lane] = clamp_s16(sum);
+    vco_lo_[lane] = 0;
+    vco_hi_[lane] = 0;
+  }
+#endif
+}
+
+void MipsRspVu::InstVsub(uint32_t opcode) {
+  VuInst inst(opcode);
+#if defined(__SSE4_1__)
+  __m128i s = load_lanes(vr_[inst.vs()]);
+  __m128i t = select_element(vr_[inst.vt()], inst.e());
+  __m128i carry = load_lanes(vco_lo_);
+  __m128i subtrahend = _mm_sub_epi16(t, carry);
+  __m128i subtrahend_sat = _mm_subs_epi16(t, carry);
+  store_lanes(acc_l_, _mm_sub_epi16(s, subtrahend));
+  // t + carry only overflows for t = 0x7FFF; take the missing 1 off after
+  __m128i overflow = _mm_cmpgt_epi16(subtrahend_sat, subtrahend);
+  __m128i result = _mm_subs_epi16(s, subtrahend_sat);
+  store_lanes(vr_[inst.vd()], _mm_adds_epi16(result, overflow));
+  store_lanes(vco_lo_, _mm_setzero_si128());
+  store_lanes(vco_hi_, _mm_setzero_si128());
+#else
+  uint16_t vt[8];
+  select_element(vt, vr_[inst.vt()], inst.e());
+  const uint16_t* vs = vr_[inst.vs()];
+  uint16_t* vd = vr_[inst.vd()];
+  for (int lane = 0; lane < 8; lane++) {
+    int32_t diff = static_cast<int16_t>(vs[lane]) - static_cast<int16_t>(vt[lane]) - (vco_lo_[lane] & 1);
+    acc_l_[lane] = diff;
+    vd[lane] = clamp_s16(diff);
+    vco_lo_[lane] = 0;
+    vco_hi_[lane] = 0;
+  }
+#endif
+}
+
+void MipsRspVu::InstVabs(uint32_t opcode) {
+  VuInst inst(opcode);
+#if defined(__SSE4_1__)
+  __m128i s = load_lanes(vr_[inst.vs()]);
+  __m128i t = select_element(vr_[inst.vt()], inst.e());
+  __m128i negative = _mm_srai_epi16(s, 15);
+  __m128i value = _mm_andnot_si128(_mm_cmpeq_epi16(s, _mm_setzero_si128()), t);
+  value = _mm_xor_si128(value, negative);
+  // -0x8000 stays 0x8000 in the accumulator but saturates in vd
+  store_lanes(acc_l_, _mm_sub_epi16(value, negative));
+  store_lanes(vr_[inst.vd()], _mm_subs_epi16(value, negative));
+#else
+  uint16_t vt[8];
+  select_element(vt, vr_[inst.vt()], inst.e());
+  const uint16_t* vs = vr_[inst.vs()];
+  uint16_t* vd = vr_[inst.vd()];
+  for (int lane = 0; lane < 8; lane++) {
+    int16_t s = vs[lane];
+    int16_t t = vt[lane];
+    if (s < 0) {
+      acc_l_[lane] = -t;
+      vd[lane] = t == INT16_MIN ? INT16_MAX : -t;
+    } else {
+      acc_l_[lane] = s == 0 ? 0 : t;
+      vd[lane] = acc_l_[lane];
+    }
+  }
+#endif
+}
+
+void MipsRspVu::InstVaddc(uint32_t opcode) {
+  VuInst inst(opcode);
+#if defined(__SSE4_1__)
+  __m128i s = load_lanes(vr_[inst.vs()]);
+  __m128i t = select_element(vr_[inst.vt()], inst.e());
+  __m128i sum = _mm_add_epi16(s, t);
+  store_lanes(vco_lo_, cmplt_epu16(sum, s));
+  store_lanes(vco_hi_, _mm_setzero_si128());
+  store_lanes(acc_l_, sum);
+  store_lanes(vr_[inst.vd()], sum);
+#else
+  uint16_t vt[8];
+  select_element(vt, vr_[inst.vt()], inst.e());
+  const uint16_t* vs = vr_[inst.vs()];
+  uint16_t* vd = vr_[inst.vd()];
+  for (int lane = 0; lane < 8; lane++) {
+    uint32_t sum = vs[lane] + vt[lane];
+    vco_lo_[lane] = mask_of(sum > 0xFFFF);
+    vco_hi_[lane] = 0;
+    acc_l_[lane] = sum;
+    vd[lane] = sum;
+  }
+#endif
+}
+
+void MipsRspVu::InstVsubc(uint32_t opcode) {
+  VuInst inst(opcode);
+#if defined(__SSE4_1__)
+  __m128i s = load_lanes(vr_[inst.vs()]);
+  __m128i t = select_element(vr_[inst.vt()], inst.e());
+  __m128i diff = _mm_sub_epi16(s, t);
+  store_lanes(vco_lo_, cmplt_epu16(s, t));
+  store_lanes(vco_hi_, _mm_xor_si128(_mm_cmpeq_epi16(s, t), all_ones()));
+  store_lanes(acc_l_, diff);
+  store_lanes(vr_[inst.vd()], diff);
+#else
+  uint16_t vt[8];
+  select_element(vt, vr_[inst.vt()], inst.e());
+  const uint16_t* vs = vr_[inst.vs()];
+  uint16_t* vd = vr_[inst.vd()];
+  for (int lane = 0; lane < 8; lane++) {
+    uint16_t diff = vs[lane] - vt[lane];
+    vco_lo_[lane] = mask_of(vs[lane] < vt[lane]);
+    vco_hi_[lane] = mask_of(vs[lane] != vt[lane]);
+    acc_l_[lane] = diff;
+    vd[lane] = diff;
+  }
+#endif
+}
+
+void MipsRspVu::InstVsar(uint32_t opcode) {
+  VuInst inst(opcode);
+  switch (inst.e()) {
+    case 8:
+      std::memcpy(vr_[inst.vd()], acc_h_, sizeof(acc_h_));
+      break;
+    case 9:
+      std::memcpy(vr_[inst.vd()], acc_m_, sizeof(acc_m_));
+      break;
+    case 10:
+      std::memcpy(vr_[inst.vd()], acc_l_, sizeof(acc_l_));
+      break;
+    default:
+      std::memset(vr_[inst.vd()], 0, sizeof(vr_[0]));
+      break;
+  }
+}
+
+template <MipsRspVu::Compare kCompare>
+void MipsRspVu::Select(uint32_t opcode) {
+  // vd = ACCL = condition ? vs : vt; VCC low gets the condition, the rest of
+  // VCC and VCO is cleared
+  VuInst inst(opcode);
+#if defined(__SSE4_1__)
+  __m128i s = load_lanes(vr_[inst.vs()]);
+  __m128i t = select_element(vr_[inst.vt()], inst.e());
+  __m128i eq = _mm_cmpeq_epi16(s, t);
+  __m128i co_lo = load_lanes(vco_lo_);
+  __m128i co_hi = load_lanes(vco_hi_);
+  __m128i cond;
+  if constexpr (kCompare == Compare::kLt) {
+    cond = _mm_or_si128(_mm_cmplt_epi16(s, t), _mm_and_si128(eq, _mm_and_si128(co_lo, co_hi)));
+  } else if constexpr (kCompare == Compare::kEq) {
+    cond = _mm_andnot_si128(co_hi, eq);
+  } else if constexpr (kCompare == Compare::kNe) {
+    cond = _mm_or_si128(_mm_xor_si128(eq, all_ones()), co_hi);
+  } else {
+    cond = _mm_or_si128(_mm_cmpgt_epi16(s, t), _mm_andnot_si128(_mm_and_si128(co_lo, co_hi), eq));
+  }
+  __m128i result = _mm_blendv_epi8(t, s, cond);
+  store_lanes(acc_l_, result);
+  store_lanes(vr_[inst.vd()], result);
+  store_lanes(vcc_lo_, cond);
+  store_lanes(vcc_hi_, _mm_setzero_si128());
+  store_lanes(vco_lo_, _mm_setzero_si128());
+  store_lanes(vco_hi_, _mm_setzero_si128());
+#else
+  uint16_t vt[8];
+  select_element(vt, vr_[inst.vt()], inst.e());
+  const uint16_t* vs = vr_[inst.vs()];
+  uint16_t* vd = vr_[inst.vd()];
+  for (int lane = 0; lane < 8; lane++) {
+    int16_t s = vs[lane];
+    int16_t t = vt[lane];
+    bool carry = vco_lo_[lane] && vco_hi_[lane];
+    bool cond;
+    if constexpr (kCompare == Compare::kLt) {
+      cond = s < t || (s == t && carry);
+    } else if constexpr (kCompare == Compare::kEq) {
+      cond = s == t && !vco_hi_[lane];
+    } else if constexpr (kCompare == Compare::kNe) {
+      cond = s != t || vco_hi_[lane];
+    } else {
+      cond = s > t || (s == t && !carry);
+    }
+    acc_l_[lane] = cond ? vs[lane] : vt[lane];
+    vd[lane] = acc_l_[lane];
+    vcc_lo_[lane] = mask_of(cond);
+    vcc_hi_[lane] = 0;
+    vco_lo_[lane] = 0;
+    vco_hi_[lane] = 0;
+  }
+#endif
+}
+
+void MipsRspVu::InstVlt(uint32_t opcode) {
+  Select<Compare::kLt>(opcode);
+}
+
+void MipsRspVu::InstVeq(uint32_t opcode) {
+  Select<Compare::kEq>(opcode);
+}
+
+void MipsRspVu::InstVne(uint32_t opcode) {
+  Select<Compare::kNe>(opcode);
+}
+
+void MipsRspVu::InstVge(uint32_t opcode) {
+  Select<Compare::kGe>(opcode);
+}
+
+void MipsRspVu::InstVcl(uint32_t opcode) {
+  VuInst inst(opcode);
+#if defined(__SSE4_1__)
+  __m128i zero = _mm_setzero_si128();
+  __m128i s = load_lanes(vr_[inst.vs()]);
+  __m128i t = select_element(vr_[inst.vt()], inst.e());
+  __m128i sign = load_lanes(vco_lo_);
+  __m128i ne = load_lanes(vco_hi_);
+  __m128i ce = load_lanes(vce_);
+  __m128i le = load_lanes(vcc_lo_);
+  __m128i ge = load_lanes(vcc_hi_);
+
+  __m128i neg_t = _mm_sub_epi16(_mm_xor_si128(t, sign), sign);
+  __m128i diff = _mm_sub_epi16(s, neg_t);
+  __m128i no_carry = _mm_cmpeq_epi16(diff, _mm_adds_epu16(s, t));
+  __m128i diff_zero = _mm_cmpeq_epi16(diff, zero);
+  __m128i le_plain = _mm_andnot_si128(ce, _mm_and_si128(diff_zero, no_carry));
+  __m128i le_ce = _mm_and_si128(ce, _mm_or_si128(diff_zero, no_carry));
+  __m128i new_le = _mm_or_si128(le_plain, le_ce);
+  __m128i new_ge = _mm_cmpeq_epi16(_mm_subs_epu16(t, s), zero);
+  // Only lanes with VCO high clear get new flags
+  le = _mm_blendv_epi8(le, new_le, _mm_andnot_si128(ne, sign));
+  ge = _mm_blendv_epi8(new_ge, ge, _mm_or_si128(sign, ne));
+
+  __m128i result = _mm_blendv_epi8(s, neg_t, _mm_blendv_epi8(ge, le, sign));
+  store_lanes(acc_l_, result);
+  store_lanes(vr_[inst.vd()], result);
+  store_lanes(vcc_lo_, le);
+  store_lanes(vcc_hi_, ge);
+  store_lanes(vco_lo_, zero);
+  store_lanes(vco_hi_, zero);
+  store_lanes(vce_, zero);
+#else
+  uint16_t vt[8];
+  select_element(vt, vr_[inst.vt()], inst.e());
+  const uint16_t* vs = vr_[inst.vs()];
+  uint16_t* vd = vr_[inst.vd()];
+  for (int lane = 0; lane < 8; lane++) {
+    uint16_t s = vs[lane];
+    uint16_t t = vt[lane];
+    if (vco_lo_[lane]) {
+      if (!vco_hi_[lane]) {
+        uint32_t sum = s + t;
+        bool is_zero = (sum & 0xFFFF) == 0;
+        bool carry = sum > 0xFFFF;
+        vcc_lo_[lane] = mask_of(vce_[lane] ? is_zero || !carry : is_zero && !carry);
+      }
+      acc_l_[lane] = vcc_lo_[lane] ? -t : s;
+    } else {
+      if (!vco_hi_[lane]) {
+        vcc_hi_[lane] = mask_of(s >= t);
+      }
+      acc_l_[lane] = vcc_hi_[lane] ? t : s;
+    }
+    vd[lane] = acc_l_[lane];
+    vco_lo_[lane] = 0;
+    vco_hi_[lane] = 0;
+    vce_[lane] = 0;
+  }
+#endif
+}
+
+void MipsRspVu::InstVch(uint32_t opcode) {
+  VuInst inst(opcode);
+#if defined(__SSE4_1__)
+  __m128i zero = _mm_setzero_si128();
+  __m128i s = load_lanes(vr_[inst.vs()]);
+  __m128i t = select_element(vr_[inst.vt()], inst.e());
+  __m128i sign = _mm_cmplt_epi16(_mm_xor_si128(s, t), zero);
+  __m128i neg_t = _mm_sub_epi16(_mm_xor_si128(t, sign), sign);
+  __m128i diff = _mm_sub_epi16(s, neg_t);
+  __m128i diff_zero = _mm_cmpeq_epi16(diff, zero);
+  __m128i t_negative = _mm_cmplt_epi16(t, zero);
+  __m128i diff_positive = _mm_cmpgt_epi16(diff, zero);
+  __m128i ge = _mm_blendv_epi8(_mm_or_si128(diff_positive, diff_zero), t_negative, sign);
+  __m128i le = _mm_blendv_epi8(t_negative, _mm_xor_si128(diff_positive, all_ones()), sign);
+  __m128i ce = _mm_and_si128(_mm_cmpeq_epi16(diff, sign), sign);
+  __m128i ne = _mm_xor_si128(_mm_or_si128(diff_zero, ce), all_ones());
+
+  __m128i result = _mm_blendv_epi8(s, neg_t, _mm_blendv_epi8(ge, le, sign));
+  store_lanes(acc_l_, result);
+  store_lanes(vr_[inst.vd()], result);
+  store_lanes(vcc_lo_, le);
+  store_lanes(vcc_hi_, ge);
+  store_lanes(vco_lo_, sign);
+  store_lanes(vco_hi_, ne);
+  store_lanes(vce_, ce);
+#else
+  uint16_t vt[8];
+  select_element(vt, vr_[inst.vt()], inst.e());
+  const uint16_t* vs = vr_[inst.vs()];
+  uint16_t* vd = vr_[inst.vd()];
+  for (int lane = 0; lane < 8; lane++) {
+    int16_t s = vs[lane];
+    int16_t t = vt[lane];
+    if ((s ^ t) < 0) {
+      int16_t sum = s + t;
+      vcc_lo_[lane] = mask_of(sum <= 0);
+      vcc_hi_[lane] = mask_of(t < 0);
+      vco_lo_[lane] = 0xFFFF;
+      vco_hi_[lane] = mask_of(sum != 0 && sum != -1);
+      vce_[lane] = mask_of(sum == -1);
+      acc_l_[lane] = vcc_lo_[lane] ? -t : s;
+    } else {
+      int16_t diff = s - t;
+      vcc_lo_[lane] = mask_of(t < 0);
+      vcc_hi_[lane] = mask_of(diff >= 0);
+      vco_lo_[lane] = 0;
+      vco_hi_[lane] = mask_of(diff != 0);
+      vce_[lane] = 0;
+      acc_l_[lane] = vcc_hi_[lane] ? t : s;
+    }
+    vd[lane] = acc_l_[lane];
+  }
+#endif
+}
+
+void MipsRspVu::InstVcr(uint32_t opcode) {
+  VuInst inst(opcode);
+#if defined(__SSE4_1__)
+  __m128i zero = _mm_setzero_si128();
+  __m128i s = load_lanes(vr_[inst.vs()]);
+  __m128i t = select_element(vr_[inst.vt()], inst.e());
+  __m128i sign = _mm_srai_epi16(_mm_xor_si128(s, t), 15);
+  __m128i le = _mm_srai_epi16(_mm_add_epi16(_mm_and_si128(s, sign), t), 15);
+  __m128i ge = _mm_cmpeq_epi16(_mm_min_epi16(_mm_or_si128(s, sign), t), t);
+  __m128i not_t = _mm_xor_si128(t, sign);
+
+  __m128i result = _mm_blendv_epi8(s, not_t, _mm_blendv_epi8(ge, le, sign));
+  store_lanes(acc_l_, result);
+  store_lanes(vr_[inst.vd()], result);
+  store_lanes(vcc_lo_, le);
+  store_lanes(vcc_hi_, ge);
+  store_lanes(vco_lo_, zero);
+  store_lanes(vco_hi_, zero);
+  store_lanes(vce_, zero);
+#else
+  uint16_t vt[8];
+  select_element(vt, vr_[inst.vt()], inst.e());
+  const uint16_t* vs = vr_[inst.vs()];
+  uint16_t* vd = vr_[inst.vd()];
+  for (int lane = 0; lane < 8; lane++) {
+    int16_t s = vs[lane];
+    int16_t t = vt[lane];
+    if ((s ^ t) < 0) {
+      vcc_lo_[lane] = mask_of(s + t + 1 <= 0);
+      vcc_hi_[lane] = mask_of(t < 0);
+      acc_l_[lane] = vcc_lo_[lane] ? ~t : s;
+    } else {
+      vcc_lo_[lane] = mask_of(t < 0);
+      vcc_hi_[lane] = mask_of(s - t >= 0);
+      acc_l_[lane] = vcc_hi_[lane] ? t : s;
+    }
+    vd[lane] = acc_l_[lane];
+    vco_lo_[lane] = 0;
+    vco_hi_[lane] = 0;
+    vce_[lane] = 0;
+  }
+#endif
+}
+
+void MipsRspVu::InstVmrg(uint32_t opcode) {
+  VuInst inst(opcode);
+#if defined(__SSE4_1__)
+  __m128i s = load_lanes(vr_[inst.vs()]);
+  __m128i t = select_element(vr_[inst.vt()], inst.e());
+  __m128i result = _mm_blendv_epi8(t, s, load_lanes(vcc_lo_));
+  store_lanes(acc_l_, result);
+  store_lanes(vr_[inst.vd()], result);
+  store_lanes(vco_lo_, _mm_setzero_si128());
+  store_lanes(vco_hi_, _mm_setzero_si128());
+#else
+  uint16_t vt[8];
+  select_element(vt, vr_[inst.vt()], inst.e());
+  const uint16_t* vs = vr_[inst.vs()];
+  uint16_t* vd = vr_[inst.vd()];
+  for (int lane = 0; lane < 8; lane++) {
+    acc_l_[lane] = vcc_lo_[lane] ? vs[lane] : vt[lane];
+    vd[lane] = acc_l_[lane];
+    vco_lo_[lane] = 0;
+    vco_hi_[lane] = 0;
+  }
+#endif
+}
+
+template <MipsRspVu::Logic kLogic>
+void MipsRspVu::Logical(uint32_t opcode) {
+  VuInst inst(opcode);
+#if defined(__SSE4_1__)
+  __m128i s = load_lanes(vr_[inst.vs()]);
+  __m128i t = select_element(vr_[inst.vt()], inst.e());
+  __m128i result;
+  if constexpr (kLogic == Logic::kAnd || kLogic == Logic::kNand) {
+    result = _mm_and_si128(s, t);
+  } else if constexpr (kLogic == Logic::kOr || kLogic == Logic::kNor) {
+    result = _mm_or_si128(s, t);
+  } else {
+    result = _mm_xor_si128(s, t);
+  }
+  if constexpr (kLogic == Logic::kNand || kLogic == Logic::kNor || kLogic == Logic::kNxor) {
+    result = _mm_xor_si128(result, all_ones());
+  }
+  store_lanes(acc_l_, result);
+  store_lanes(vr_[inst.vd()], result);
+#else
+  uint16_t vt[8];
+  select_element(vt, vr_[inst.vt()], inst.e());
+  const uint16_t* vs = vr_[inst.vs()];
+  uint16_t* vd = vr_[inst.vd()];
+  for (int lane = 0; lane < 8; lane++) {
+    uint16_t result;
+    if constexpr (kLogic == Logic::kAnd || kLogic == Logic::kNand) {
+      result = vs[lane] & vt[lane];
+    } else if constexpr (kLogic == Logic::kOr || kLogic == Logic::kNor) {
+      result = vs[lane] | vt[lane];
+    } else {
+      result = vs[lane] ^ vt[lane];
+    }
+    if constexpr (kLogic == Logic::kNand || kLogic == Logic::kNor || kLogic == Logic::kNxor) {
+      result = ~result;
+    }
+    acc_l_[lane] = result;
+    vd[lane] = result;
+  }
+#endif
+}
+
+void MipsRspVu::InstVand(uint32_t opcode) {
+  Logical<Logic::kAnd>(opcode);
+}
+
+void MipsRspVu::InstVnand(uint32_t opcode) {
+  Logical<Logic::kNand>(opcode);
+}
+
+void MipsRspVu::InstVor(uint32_t opcode) {
+  Logical<Logic::kOr>(opcode);
+}
+
+void MipsRspVu::InstVnor(uint32_t opcode) {
+  Logical<Logic::kNor>(opcode);
+}
+
+void MipsRspVu::InstVxor(uint32_t opcode) {
+  Logical<Logic::kXor>(opcode);
+}
+
+void MipsRspVu::InstVnxor(uint32_t opcode) {
+  Logical<Logic::kNxor>(opcode);
+}
+
+// Single-lane ops: vs is the destination element, vt[e & 7] the source.
+// ACCL always receives the element-selected vt.
+template <bool kIsReciprocal, bool kIsLong>
+void MipsRspVu::Divide(uint32_t opcode) {
+  VuInst inst(opcode);
+  uint16_t source = vr_[inst.vt()][inst.e() & 7];
+  int32_t input;
+  if (kIsLong && div_dp_) {
+    input = static_cast<int32_t>((static_cast<uint32_t>(static_cast<uint16_t>(div_in_)) << 16) | source);
+  } else {
+    input = static_cast<int16_t>(source);
+  }
+
+  uint32_t mask = input >> 31;
+  uint32_t data = input ^ mask;
+  if (input > -32768) {
+    data -= mask;
+  }
+
+  uint32_t result;
+  if (data == 0) {
+    result = 0x7FFFFFFF;
+  } else if (input == -32768) {
+    result = 0xFFFF0000;
+  } else {
+    const DivideTable& table = get_divide_table();
+    int shift = std::countl_zero(data);
+    uint32_t index = ((static_cast<uint64_t>(data) << shift) & 0x7FC00000) >> 22;
+    if (kIsReciprocal) {
+      result = (0x10000 | table.reciprocal_[index]) << 14;
+      result = (result >> (31 - shift)) ^ mask;
+    } else {
+      result = (0x10000 | table.inverse_sqrt_[(index & 0x1FE) | (shift & 1)]) << 14;
+      result = (result >> ((31 - shift) >> 1)) ^ mask;
+    }
+  }
+
+  div_dp_ = false;
+  div_out_ = result >> 16;
+  for (int lane = 0; lane < 8; lane++) {
+    acc_l_[lane] = vr_[inst.vt()][kElementTable.index_[inst.e()][lane]];
+  }
+  vr_[inst.vd()][inst.vs() & 7] = result;
+}
+
+void MipsRspVu::DivideHigh(uint32_t opcode) {
+  VuInst inst(opcode);
+  for (int lane = 0; lane < 8; lane++) {
+    acc_l_[lane] = vr_[inst.vt()][kElementTable.index_[inst.e()][lane]];
+  }
+  div_dp_ = true;
+  div_in_ = vr_[inst.vt()][inst.e() & 7];
+  vr_[inst.vd()][inst.vs() & 7] = div_out_;
+}
+
+void MipsRspVu::InstVrcp(uint32_t opcode) {
+  Divide<true, false>(opcode);
+}
+
+void MipsRspVu::InstVrcpl(uint32_t opcode) {
+  Divide<true, true>(opcode);
+}
+
+void MipsRspVu::InstVrcph(uint32_t opcode) {
+  DivideHigh(opcode);
+}
+
+void MipsRspVu::InstVmov(uint32_t opcode) {
+  VuInst inst(opcode);
+  for (int lane = 0; lane < 8; lane++) {
+    acc_l_[lane] = vr_[inst.vt()][kElementTable.index_[inst.e()][lane]];
+  }
+  int de = inst.vs() & 7;
+  vr_[inst.vd()][de] = acc_l_[de];
+}
+
+void MipsRspVu::InstVrsq(uint32_t opcode) {
+  Divide<false, false>(opcode);
+}
+
+void MipsRspVu::InstVrsql(uint32_t opcode) {
+  Divide<false, true>(opcode);
+}
+
+void MipsRspVu::InstVrsqh(uint32_t opcode) {
+  DivideHigh(opcode);
+}
+
+void MipsRspVu::InstVnop(uint32_t opcode) {
+}
+
+// Reserved encodings still write vs + vt to ACCL and clear vd
+void MipsRspVu::InstVzero(uint32_t opcode) {
+  VuInst inst(opcode);
+  for (int lane = 0; lane < 8; lane++) {
+    acc_l_[lane] = vr_[inst.vs()][lane] + vr_[inst.vt()][kElementTable.index_[inst.e()][lane]];
+  }
+  std::memset(vr_[inst.vd()], 0, sizeof(vr_[0]));
+}
+
+void MipsRspVu::LoadGroup(uint32_t opcode, uint32_t base, int size) {
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * size;
+  int end = std::min(inst.element() + size, 16);
+  for (int i = inst.element(); i < end; i++) {
+    SetByte(inst.vt(), i, ReadDmem(address++));
+  }
+}
+
+void MipsRspVu::StoreGroup(uint32_t opcode, uint32_t base, int size) {
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * size;
+  for (int i = 0; i < size; i++) {
+    WriteDmem(address + i, GetByte(inst.vt(), (inst.element() + i) & 15));
+  }
+}
+
+void MipsRspVu::InstLbv(uint32_t opcode, uint32_t base) {
+  LoadGroup(opcode, base, 1);
+}
+
+void MipsRspVu::InstLsv(uint32_t opcode, uint32_t base) {
+  LoadGroup(opcode, base, 2);
+}
+
+void MipsRspVu::InstLlv(uint32_t opcode, uint32_t base) {
+  LoadGroup(opcode, base, 4);
+}
+
+void MipsRspVu::InstLdv(uint32_t opcode, uint32_t base) {
+#if defined(__SSE4_1__)
+  VuInst inst(opcode);
+  uint32_t address = (base + inst.offset() * 8) & kDmemMask;
+  if (dmem_ != nullptr && address <= kDmemMask - 7) {
+    // Register byte j comes from DMEM byte j - e
+    __m128i data = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(dmem_ + address));
+    __m128i index = _mm_sub_epi8(swapped_byte_index(), _mm_set1_epi8(inst.element()));
+    __m128i valid = _mm_and_si128(_mm_cmpgt_epi8(index, _mm_set1_epi8(-1)), _mm_cmplt_epi8(index, _mm_set1_epi8(8)));
+    uint16_t* vt = vr_[inst.vt()];
+    store_lanes(vt, _mm_blendv_epi8(load_lanes(vt), _mm_shuffle_epi8(data, index), valid));
+    return;
+  }
+#endif
+  LoadGroup(opcode, base, 8);
+}
+
+void MipsRspVu::InstLqv(uint32_t opcode, uint32_t base) {
+  // Up to the end of the 16-byte line, so it never crosses the 4 KB wrap
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 16;
+#if defined(__SSE4_1__)
+  if (dmem_ != nullptr) {
+    int start = address & 15;
+    // Register byte j comes from line byte j - e + start, for those that
+    // land inside the line
+    __m128i line = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dmem_ + (address & kDmemMask & ~15)));
+    __m128i index = _mm_add_epi8(swapped_byte_index(), _mm_set1_epi8(start - inst.element()));
+    __m128i valid =
+        _mm_and_si128(_mm_cmpgt_epi8(index, _mm_set1_epi8(start - 1)), _mm_cmplt_epi8(index, _mm_set1_epi8(16)));
+    uint16_t* vt = vr_[inst.vt()];
+    store_lanes(vt, _mm_blendv_epi8(load_lanes(vt), _mm_shuffle_epi8(line, index), valid));
+    return;
+  }
+#endif
+  int end = std::min<int>(16 + inst.element() - (address & 15), 16);
+  for (int i = inst.element(); i < end; i++) {
+    SetByte(inst.vt(), i, ReadDmem(address++));
+  }
+}
+
+void MipsRspVu::InstLrv(uint32_t opcode, uint32_t base) {
+  // From the start of the 16-byte line up to the address
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 16;
+  int start = inst.element() + (16 - (address & 15));
+  address &= ~15;
+  for (int i = start; i < 16; i++) {
+    SetByte(inst.vt(), i, ReadDmem(address++));
+  }
+}
+
+void MipsRspVu::LoadPacked(uint32_t opcode, uint32_t base, int shift) {
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 8;
+  int index = (address & 7) - inst.element();
+  address &= ~7;
+  for (int lane = 0; lane < 8; lane++) {
+    vr_[inst.vt()][lane] = ReadDmem(address + ((index + lane) & 15)) << shift;
+  }
+}
+
+void MipsRspVu::InstLpv(uint32_t opcode, uint32_t base) {
+  LoadPacked(opcode, base, 8);
+}
+
+void MipsRspVu::InstLuv(uint32_t opcode, uint32_t base) {
+  LoadPacked(opcode, base, 7);
+}
+
+void MipsRspVu::InstLhv(uint32_t opcode, uint32_t base) {
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 16;
+  int index = (address & 7) - inst.element();
+  address &= ~7;
+  for (int lane = 0; lane < 8; lane++) {
+    vr_[inst.vt()][lane] = ReadDmem(address + ((index + lane * 2) & 15)) << 7;
+  }
+}
+
+void MipsRspVu::InstLfv(uint32_t opcode, uint32_t base) {
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 16;
+  int index = (address & 7) - inst.element();
+  address &= ~7;
+  uint16_t lanes[8];
+  for (int i = 0; i < 4; i++) {
+    lanes[i] = ReadDmem(address + ((index + i * 4) & 15)) << 7;
+    lanes[i + 4] = ReadDmem(address + ((index + i * 4 + 8) & 15)) << 7;
+  }
+  int end = std::min(inst.element() + 8, 16);
+  for (int i = inst.element(); i < end; i++) {
+    SetByte(inst.vt(), i, (i & 1) ? lanes[i >> 1] : lanes[i >> 1] >> 8);
+  }
+}
+
+void MipsRspVu::InstLtv(uint32_t opcode, uint32_t base) {
+  // Transposed: byte pairs go to the same lane of eight consecutive registers
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 16;
+  uint32_t begin = address & ~7;
+  address = begin + ((inst.element() + (address & 8)) & 15);
+  int vt_base = inst.vt() & ~7;
+  int vt_offset = inst.element() >> 1;
+  for (int i = 0; i < 8; i++) {
+    for (int j = 0; j < 2; j++) {
+      SetByte(vt_base + vt_offset, i * 2 + j, ReadDmem(address++));
+      if (address == begin + 16) {
+        address = begin;
+      }
+    }
+    vt_offset = (vt_offset + 1) & 7;
+  }
+}
+
+void MipsRspVu::InstSbv(uint32_t opcode, uint32_t base) {
+  StoreGroup(opcode, base, 1);
+}
+
+void MipsRspVu::InstSsv(uint32_t opcode, uint32_t base) {
+  StoreGroup(opcode, base, 2);
+}
+
+void MipsRspVu::InstSlv(uint32_t opcode, uint32_t base) {
+  StoreGroup(opcode, base, 4);
+}
+
+void MipsRspVu::InstSdv(uint32_t opcode, uint32_t base) {
+#if defined(__SSE4_1__)
+  VuInst inst(opcode);
+  uint32_t address = (base + inst.offset() * 8) & kDmemMask;
+  if (dmem_ != nullptr && address <= kDmemMask - 7) {
+    // DMEM byte i comes from register byte (e + i) & 15
+    __m128i index = rotated_byte_index(inst.element());
+    __m128i data = _mm_shuffle_epi8(load_lanes(vr_[inst.vt()]), index);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dmem_ + address), data);
+    return;
+  }
+#endif
+  StoreGroup(opcode, base, 8);
+}
+
+void MipsRspVu::InstSqv(uint32_t opcode, uint32_t base) {
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 16;
+#if defined(__SSE4_1__)
+  if (dmem_ != nullptr) {
+    // Line byte p, from the address to the end of the line, comes from
+    // register byte (e + p - start) & 15
+    int start = address & 15;
+    uint8_t* target = dmem_ + (address & kDmemMask & ~15);
+    __m128i line = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target));
+    __m128i data = _mm_shuffle_epi8(load_lanes(vr_[inst.vt()]), rotated_byte_index(inst.element() - start));
+    __m128i valid = _mm_cmpgt_epi8(byte_index(), _mm_set1_epi8(start - 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(target), _mm_blendv_epi8(line, data, valid));
+    return;
+  }
+#endif
+  int end = inst.element() + (16 - (address & 15));
+  for (int i = inst.element(); i < end; i++) {
+    WriteDmem(address++, GetByte(inst.vt(), i & 15));
+  }
+}
+
+void MipsRspVu::InstSrv(uint32_t opcode, uint32_t base) {
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 16;
+  int end = inst.element() + (address & 15);
+  int rotate = 16 - (address & 15);
+  address &= ~15;
+  for (int i = inst.element(); i < end; i++) {
+    WriteDmem(address++, GetByte(inst.vt(), (i + rotate) & 15));
+  }
+}
+
+void MipsRspVu::StorePacked(uint32_t opcode, uint32_t base, bool is_unsigned) {
+  // SPV stores the high byte of each lane, SUV the lane >> 7; which form a
+  // lane gets flips for elements 8-15
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 8;
+  for (int i = inst.element(); i < inst.element() + 8; i++) {
+    bool is_high_byte = ((i & 15) < 8) != is_unsigned;
+    if (is_high_byte) {
+      WriteDmem(address++, GetByte(inst.vt(), (i & 7) << 1));
+    } else {
+      WriteDmem(address++, vr_[inst.vt()][i & 7] >> 7);
+    }
+  }
+}
+
+void MipsRspVu::InstSpv(uint32_t opcode, uint32_t base) {
+  StorePacked(opcode, base, false);
+}
+
+void MipsRspVu::InstSuv(uint32_t opcode, uint32_t base) {
+  StorePacked(opcode, base, true);
+}
+
+void MipsRspVu::InstShv(uint32_t opcode, uint32_t base) {
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 16;
+  int index = address & 7;
+  address &= ~7;
+  for (int i = 0; i < 8; i++) {
+    int byte = inst.element() + i * 2;
+    uint8_t value = (GetByte(inst.vt(), byte & 15) << 1) | (GetByte(inst.vt(), (byte + 1) & 15) >> 7);
+    WriteDmem(address + ((index + i * 2) & 15), value);
+  }
+}
+
+void MipsRspVu::InstSfv(uint32_t opcode, uint32_t base) {
+  // Only some elements select a lane order; the rest store zeros
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 16;
+  int index = address & 7;
+  address &= ~7;
+  static const int8_t kSfvLanes[16][4] = {
+      {0, 1, 2, 3}, {6, 7, 4, 5}, {-1}, {-1}, {1, 2, 3, 0}, {7, 4, 5, 6}, {-1}, {-1},
+      {4, 5, 6, 7}, {-1}, {-1}, {3, 0, 1, 2}, {5, 6, 7, 4}, {-1}, {-1}, {0, 1, 2, 3},
+  };
+  const int8_t* lanes = kSfvLanes[inst.element()];
+  for (int i = 0; i < 4; i++) {
+    uint8_t value = lanes[0] < 0 ? 0 : vr_[inst.vt()][lanes[i]] >> 7;
+    WriteDmem(address + ((index + i * 4) & 15), value);
+  }
+}
+
+void MipsRspVu::InstSwv(uint32_t opcode, uint32_t base) {
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 16;
+  int index = address & 7;
+  address &= ~7;
+  for (int i = inst.element(); i < inst.element() + 16; i++) {
+    WriteDmem(address + (index++ & 15), GetByte(inst.vt(), i & 15));
+  }
+}
+
+void MipsRspVu::InstStv(uint32_t opcode, uint32_t base) {
+  // Inverse of LTV
+  VuInst inst(opcode);
+  uint32_t address = base + inst.offset() * 16;
+  int vt_base = inst.vt() & ~7;
+  int element = 16 - (inst.element() & ~1);
+  int index = (address & 7) - (inst.element() & ~1);
+  address &= ~7;
+  for (int vt = vt_base; vt < vt_base + 8; vt++) {
+    WriteDmem(address + (index++ & 15), GetByte(vt, element++ & 15));
+    WriteDmem(address + (index++ & 15), GetByte(vt, element++ & 15));
+  }
+}
+
+void MipsRspVu::InstMemoryNop(uint32_t opcode, uint32_t base) {
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstdint>
+
+#include "mips_cop.h"
+
+class BusBase;
+
+// RSP vector unit (COP2): 32 registers of eight 16-bit lanes, a 48-bit
+// accumulator per lane and the VCO/VCC/VCE flag registers. Created by
+// MipsBase when MipsConfig::has_rsp_vu_ is set. The CPU then resolves COP2,
+// LWC2 and SWC2 opcodes to the Inst* handlers below when it decodes them, so
+// a vector op in a cached block is one direct call with no Command() switch.
+// Command() still decodes everything for use as a plain MipsCopBase.
+//
+// Vector loads and stores address DMEM with 12 bits, wrapping at 4 KB. If
+// the bus exposes a DMEM pointer they use it directly, with LQV/SQV/LDV/SDV
+// moving whole vectors through byte shuffles.
+//
+// Lane arithmetic uses SSE4.1 when this file is compiled with it
+// (NGMIPS_RSP_VU_SSE41) and a portable per-lane loop otherwise. Both produce
+// the same results.
+class MipsRspVu : public MipsCopBase {
+ public:
+  using Handler = void (MipsRspVu::*)(uint32_t);
+  // Loads and stores also take the value of the base GPR
+  using MemoryHandler = void (MipsRspVu::*)(uint32_t, uint32_t);
+
+  MipsRspVu();
+
+  void ConnectCpu(MipsInterface* cpu) override;
+  void ConnectBus(BusBase* bus);
+  void Reset() override;
+  void Command(uint32_t command) override;
+  // idx 0-31 read element 0 of a register, 32+ the control registers
+  uint32_t Read32(int idx) override;
+  void Write32(int idx, uint32_t value) override;
+  uint64_t Read64(int idx) override { return Read32(idx); }
+  void Write64(int idx, uint64_t value) override { Write32(idx, value); }
+  uint32_t Read32Internal(int idx) override { return 0; }
+  void Write32Internal(int idx, uint32_t value) override {}
+  uint64_t Read64Internal(int idx) override { return 0; }
+  void Write64Internal(int idx, uint64_t value) override {}
+  bool GetFlag() override { return false; }
+  void SaveState(MipsStateWriter& writer) override;
+  bool LoadState(MipsStateReader& reader, bool commit) override;
+
+  static Handler GetComputeHandler(uint32_t opcode);
+  static MemoryHandler GetLoadHandler(uint32_t opcode);
+  static MemoryHandler GetStoreHandler(uint32_t opcode);
+
+  // MFC2/MTC2 move the two bytes starting at byte `element` of a register,
+  // CFC2/CTC2 pack the flags as VCO = 0, VCC = 1, VCE = 2
+  uint32_t ReadElement(int vs, int element);
+  void WriteElement(int vs, int element, uint32_t value);
+  uint32_t ReadControl(int idx);
+  void WriteControl(int idx, uint32_t value);
+
+  void InstVmulf(uint32_t opcode);
+  void InstVmulu(uint32_t opcode);
+  void InstVrndp(uint32_t opcode);
+  void InstVmulq(uint32_t opcode);
+  void InstVmudl(uint32_t opcode);
+  void InstVmudm(uint32_t opcode);
+  void InstVmudn(uint32_t opcode);
+  void InstVmudh(uint32_t opcode);
+  void InstVmacf(uint32_t opcode);
+  void InstVmacu(uint32_t opcode);
+  void InstVrndn(uint32_t opcode);
+  void InstVmacq(uint32_t opcode);
+  void InstVmadl(uint32_t opcode);
+  void InstVmadm(uint32_t opcode);
+  void InstVmadn(uint32_t opcode);
+  void InstVmadh(uint32_t opcode);
+  void InstVadd(uint32_t opcode);
+  void InstVsub(uint32_t opcode);
+  void InstVabs(uint32_t opcode);
+  void InstVaddc(uint32_t opcode);
+  void InstVsubc(uint32_t opcode);
+  void InstVsar(uint32_t opcode);
+  void InstVlt(uint32_t opcode);
+  void InstVeq(uint32_t opcode);
+  void InstVne(uint32_t opcode);
+  void InstVge(uint32_t opcode);
+  void InstVcl(uint32_t opcode);
+  void InstVch(uint32_t opcode);
+  void InstVcr(uint32_t opcode);
+  void InstVmrg(uint32_t opcode);
+  void InstVand(uint32_t opcode);
+  void InstVnand(uint32_t opcode);
+  void InstVor(uint32_t opcode);
+  void InstVnor(uint32_t opcode);
+  void InstVxor(uint32_t opcode);
+  void InstVnxor(uint32_t opcode);
+  void InstVrcp(uint32_t opcode);
+  void InstVrcpl(uint32_t opcode);
+  void InstVrcph(uint32_t opcode);
+  void InstVmov(uint32_t opcode);
+  void InstVrsq(uint32_t opcode);
+  void InstVrsql(uint32_t opcode);
+  void InstVrsqh(uint32_t opcode);
+  void InstVnop(uint32_t opcode);
+  void InstVzero(uint32_t opcode);
+
+  void InstLbv(uint32_t opcode, uint32_t base);
+  void InstLsv(uint32_t opcode, uint32_t base);
+  void InstLlv(uint32_t opcode, uint32_t base);
+  void InstLdv(uint32_t opcode, uint32_t base);
+  void InstLqv(uint32_t opcode, uint32_t base);
+  void InstLrv(uint32_t opcode, uint32_t base);
+  void InstLpv(uint32_t opcode, uint32_t base);
+  void InstLuv(uint32_t opcode, uint32_t base);
+  void InstLhv(uint32_t opcode, uint32_t base);
+  void InstLfv(uint32_t opcode, uint32_t base);
+  void InstLtv(uint32_t opcode, uint32_t base);
+  void InstSbv(uint32_t opcode, uint32_t base);
+  void InstSsv(uint32_t opcode, uint32_t base);
+  void InstSlv(uint32_t opcode, uint32_t base);
+  void InstSdv(uint32_t opcode, uint32_t base);
+  void InstSqv(uint32_t opcode, uint32_t base);
+  void InstSrv(uint32_t opcode, uint32_t base);
+  void InstSpv(uint32_t opcode, uint32_t base);
+  void InstSuv(uint32_t opcode, uint32_t base);
+  void InstShv(uint32_t opcode, uint32_t base);
+  void InstSfv(uint32_t opcode, uint32_t base);
+  void InstSwv(uint32_t opcode, uint32_t base);
+  void InstStv(uint32_t opcode, uint32_t base);
+  void InstMemoryNop(uint32_t opcode, uint32_t base);
+
+ private:
+  enum class Product { kFrac, kLow, kMid, kMidN, kHigh };
+  enum class Clamp { kSignedMid, kUnsignedMid, kLow };
+  enum class Compare { kLt, kEq, kNe, kGe };
+  enum class Logic { kAnd, kNand, kOr, kNor, kXor, kNxor };
+
+  template <Product kProduct, Clamp kClamp, bool kAccumulate>
+  void Multiply(uint32_t opcode);
+  template <Compare kCompare>
+  void Select(uint32_t opcode);
+  template <Logic kLogic>
+  void Logical(uint32_t opcode);
+  template <bool kIsReciprocal, bool kIsLong>
+  void Divide(uint32_t opcode);
+  void DivideHigh(uint32_t opcode);
+  void Round(uint32_t opcode, bool is_negative);
+  // LSV/LLV/LDV and SSV/SLV/SDV move `size` bytes starting at the element
+  void LoadGroup(uint32_t opcode, uint32_t base, int size);
+  void StoreGroup(uint32_t opcode, uint32_t base, int size);
+  // LPV/LUV and SPV/SUV, which differ only in the shift and lane order
+  void LoadPacked(uint32_t opcode, uint32_t base, int shift);
+  void StorePacked(uint32_t opcode, uint32_t base, bool is_unsigned);
+
+  int64_t GetAcc(int lane);
+  void SetAcc(int lane, int64_t value);
+  uint8_t GetByte(int vt, int index);
+  void SetByte(int vt, int index, uint8_t value);
+  uint8_t ReadDmem(uint32_t address);
+  void WriteDmem(uint32_t address, uint8_t value);
+
+  MipsInterface* cpu_ = nullptr;
+  BusBase* bus_ = nullptr;
+  uint8_t* dmem_ = nullptr;
+
+  // Lane i holds element i
+  alignas(16) uint16_t vr_[32][8];
+  alignas(16) uint16_t acc_h_[8];
+  alignas(16) uint16_t acc_m_[8];
+  alignas(16) uint16_t acc_l_[8];
+  // Flags are kept as 0x0000/0xFFFF lane masks
+  alignas(16) uint16_t vco_lo_[8];
+  alignas(16) uint16_t vco_hi_[8];
+  alignas(16) uint16_t vcc_lo_[8];
+  alignas(16) uint16_t vcc_hi_[8];
+  alignas(16) uint16_t vce_[8];
+  int16_t div_in_;
+  int16_t div_out_;
+  bool div_dp_;
+};
@@ -0,0 +1,108 @@
+#include "mips_skew_coordinator.h"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+namespace {
+
+const uint64_t kFinished = std::numeric_limits<uint64_t>::max();
+
+// Processor the current thread is running for, if any
+thread_local const MipsSkewCoordinator* current_coordinator = nullptr;
+thread_local int current_processor = -1;
+
+}  // namespace
+
+MipsSkewCoordinator::MipsSkewCoordinator(int max_skew) {
+  max_skew_ = max_skew;
+}
+
+int MipsSkewCoordinator::AddProcessor(MipsInterface* cpu, int slice_cycles) {
+  auto processor = std::make_unique<Processor>();
+  processor->cpu_ = cpu;
+  processor->slice_cycles_ = slice_cycles;
+  processor->completed_ = 0;
+  processors_.push_back(std::move(processor));
+  return processors_.size() - 1;
+}
+
+void MipsSkewCoordinator::ConnectBus(BusBase* bus) {
+  bus->SetSyncHandler(this);
+}
+
+// completed_ changes under mutex_, so a waiter cannot miss the notification
+// between checking its predicate and going to sleep
+void MipsSkewCoordinator::SetCompleted(Processor& processor, uint64_t completed) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    processor.completed_.store(completed, std::memory_order_release);
+  }
+  progress_.notify_all();
+}
+
+template <typename Predicate>
+void MipsSkewCoordinator::WaitUntil(Predicate predicate) {
+  if (predicate()) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  progress_.wait(lock, predicate);
+}
+
+void MipsSkewCoordinator::Run(uint64_t slice_count) {
+  for (auto& processor : processors_) {
+    processor->completed_.store(0, std::memory_order_relaxed);
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < processors_.size(); i++) {
+    threads.emplace_back(&MipsSkewCoordinator::ProcessorMain, this, i, slice_count);
+  }
+  // The calling thread runs the first processor
+  if (!processors_.empty()) {
+    ProcessorMain(0, slice_count);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+void MipsSkewCoordinator::SyncPoint() {
+  if (current_coordinator != this) {
+    return;
+  }
+  const int index = current_processor;
+  const uint64_t completed = processors_[index]->completed_.load(std::memory_order_relaxed);
+  WaitUntil([&]() { return GetSlowestOther(index) >= completed; });
+}
+
+void MipsSkewCoordinator::ProcessorMain(int index, uint64_t slice_count) {
+  current_coordinator = this;
+  current_processor = index;
+
+  Processor& processor = *processors_[index];
+  for (uint64_t slice = 0; slice < slice_count; slice++) {
+    WaitUntil([&]() {
+      uint64_t slowest = GetSlowestOther(index);
+      return slowest == kFinished || slice <= slowest + max_skew_;
+    });
+    processor.cpu_->Run(processor.slice_cycles_);
+    SetCompleted(processor, slice + 1);
+  }
+  // Nobody has to wait for a processor that has used up its slices
+  SetCompleted(processor, kFinished);
+
+  current_coordinator = nullptr;
+  current_processor = -1;
+}
+
+uint64_t MipsSkewCoordinator::GetSlowestOther(int index) const {
+  uint64_t slowest = kFinished;
+  for (size_t i = 0; i < processors_.size(); i++) {
+    if (static_cast<int>(i) != index) {
+      slowest = std::min(slowest, processors_[i]->completed_.load(std::memory_order_acquire));
+    }
+  }
+  return slowest;
+}
@@ -2,6 +2,10 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <iterator>
+
+#include "mips_state.h"
 #include "panic.h"
 
 MipsTlbNormal::MipsTlbNormal() {
@@ -13,23 +17,12 @@ void MipsTlbNormal::Reset() {
   }
 }
 
-MipsTlbTranslationResult MipsTlbNormal::TranslateAddress(uint64_t address) {
-  address &= 0xFFFFFFFF;
-
+MipsTlbTranslationResult MipsTlbNormal::TranslateMapped(uint64_t address) {
   MipsTlbTranslationResult result;
   result.found_ = false;
   result.read_only_ = false;
   result.address_ = 0;
 
-  bool is_kseg0 = address >= 0x80000000 && address < 0xA0000000;
-  bool is_kseg1 = address >= 0xA0000000 && address < 0xC0000000;
-  if (is_kseg0 || is_kseg1) {
-    result.found_ = true;
-    result.read_only_ = false;
-    result.address_ = address & 0x1FFFFFFF;
-    return result;
-  }
-
   uint8_t asid = entry_hi_ & 0xFF;
   for (int i = 0; i < 32; i++) {
     const MipsTlbEntry& entry = entry_[i];
@@ -134,3 +127,40 @@ uint32_t MipsTlbNormal::ProbeTlbEntry() {
   }
   return 0x80000000;
 }
+
+void MipsTlbNormal::SaveState(MipsStateWriter& writer) {
+  writer.Write(entry_);
+  writer.Write(entry_hi_);
+  writer.Write(entry_lo0_);
+  writer.Write(entry_lo1_);
+  writer.Write(page_mask_);
+  writer.Write(index_);
+}
+
+bool MipsTlbNormal::LoadState(MipsStateReader& reader, bool commit) {
+  MipsTlbEntry entry[32];
+  uint64_t entry_hi = 0;
+  uint64_t entry_lo0 = 0;
+  uint64_t entry_lo1 = 0;
+  uint64_t page_mask = 0;
+  uint32_t index = 0;
+  reader.Read(entry);
+  reader.Read(entry_hi);
+  reader.Read(entry_lo0);
+  reader.Read(entry_lo1);
+  reader.Read(page_mask);
+  reader.Read(index);
+  if (!reader.IsGood()) {
+    return false;
+  }
+
+  if (commit) {
+    std::copy(std::begin(entry), std::end(entry), entry_);
+    entry_hi_ = entry_hi;
+    entry_lo0_ = entry_lo0;
+    entry_lo1_ = entry_lo1;
+    page_mask_ = page_mask;
+    index_ = index;
+  }
+  return true;
+}
@@ -3,10 +3,17 @@
 #include <stdio.h>
 #include <signal.h>
 
-#define PANIC(...)                            \
-  fmt::print("{}:{} | ", __LINE__, __FILE__); \
-  fmt::print(__VA_ARGS__);                            \
-  fmt::print("\n");                           \
-  fflush(stdout);                             \
-  fflush(stderr);                             \
-  raise(SIGABRT)
+#include <string>
+
+// The message is formatted first and written with a single call, so panics
+// from CPUs on different threads don't interleave mid-line
+#define PANIC(...)                                                                 \
+  do {                                                                             \
+    std::string panic_message =                                                    \
+        fmt::format("{}:{} | {}\n", __LINE__, __FILE__, fmt::format(__VA_ARGS__)); \
+    fflush(stdout);                                                                \
+    fwrite(panic_message.data(), 1, panic_message.size(), stdout);                 \
+    fflush(stdout);                                                                \
+    fflush(stderr);                                                                \
+    raise(SIGABRT);                                                                \
+  } while (0)